@@ -1,7 +1,9 @@
 #ifndef LIBRTS_H
 #define LIBRTS_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 #define RTS_EXTERN extern "C"
@@ -9,6 +11,10 @@
 #define RTS_EXTERN extern
 #endif
 
+#ifndef RTS_CACHE_LINE_SIZE
+#define RTS_CACHE_LINE_SIZE 64
+#endif
+
 typedef enum _RtsTypeTag {
     RTS_TYPE_TAG_UINT,
     RTS_TYPE_TAG_SINT,
@@ -35,11 +41,17 @@ typedef enum _RtsTypeTag {
     RTS_TYPE_TAG_POINTER,
     RTS_TYPE_TAG_STRUCT,
     RTS_TYPE_TAG_UNION,
+    RTS_TYPE_TAG_FLEXIBLE,
 } RtsTypeTag;
 
 typedef enum _RtsStatus {
     RTS_STATUS_OK = 0,
-    RTS_STATUS_BAD_TYPEDEF
+    RTS_STATUS_BAD_TYPEDEF,
+    RTS_STATUS_BAD_SIZE,
+    RTS_STATUS_IO_ERROR,
+    RTS_STATUS_BAD_EXPRESSION,
+    RTS_STATUS_NO_MEMORY,
+    RTS_STATUS_UNSUPPORTED
 } RtsStatus;
 
 typedef struct _RtsType {
@@ -48,6 +60,7 @@ typedef struct _RtsType {
     size_t size;
     struct _RtsType **elements;
     size_t *offsets;
+    size_t count_field;
 } RtsType;
 
 RTS_EXTERN RtsType RTS_TYPE_UINT;
@@ -75,5 +88,170 @@ RTS_EXTERN RtsType RTS_TYPE_SINT64;
 RTS_EXTERN RtsType RTS_TYPE_POINTER;
 
 RTS_EXTERN RtsStatus rts_type_init(RtsType *type);
+RTS_EXTERN bool rts_type_is_variable(const RtsType *type);
+
+typedef enum _RtsViewFlags {
+    RTS_VIEW_FLAG_NONE = 0,
+    RTS_VIEW_FLAG_WRITABLE = 1 << 0,
+    RTS_VIEW_FLAG_SEQUENTIAL = 1 << 1,
+    RTS_VIEW_FLAG_RANDOM = 1 << 2,
+    RTS_VIEW_FLAG_HUGE_PAGES = 1 << 3,
+} RtsViewFlags;
+
+typedef struct _RtsView {
+    const RtsType *type;
+    void *base;
+    size_t length;
+    size_t count;
+} RtsView;
+
+typedef struct _RtsViewIter {
+    const RtsView *view;
+    size_t index;
+} RtsViewIter;
+
+RTS_EXTERN RtsStatus rts_view_open(RtsView *view, const RtsType *type, const char *path, int flags);
+RTS_EXTERN void rts_view_close(RtsView *view);
+RTS_EXTERN void *rts_view_at(const RtsView *view, size_t index);
+RTS_EXTERN void rts_view_iter_init(RtsViewIter *iter, const RtsView *view);
+RTS_EXTERN void *rts_view_iter_next(RtsViewIter *iter);
+
+typedef enum _RtsFilterOp {
+    RTS_FILTER_OP_EQ,
+    RTS_FILTER_OP_NE,
+    RTS_FILTER_OP_LT,
+    RTS_FILTER_OP_LE,
+    RTS_FILTER_OP_GT,
+    RTS_FILTER_OP_GE,
+    RTS_FILTER_OP_AND,
+    RTS_FILTER_OP_OR,
+} RtsFilterOp;
+
+typedef union _RtsFilterValue {
+    int64_t s;
+    uint64_t u;
+    double f;
+} RtsFilterValue;
+
+typedef struct _RtsFilterExpr {
+    RtsFilterOp op;
+    size_t field;
+    RtsFilterValue value;
+    const struct _RtsFilterExpr *lhs;
+    const struct _RtsFilterExpr *rhs;
+} RtsFilterExpr;
+
+typedef struct _RtsFilter {
+    struct _RtsFilterInsn *program;
+    size_t length;
+    size_t stride;
+} RtsFilter;
+
+RTS_EXTERN RtsStatus rts_filter_compile(RtsFilter *filter, const RtsType *type, const RtsFilterExpr *expr);
+RTS_EXTERN void rts_filter_free(RtsFilter *filter);
+RTS_EXTERN void rts_filter_bitmap(const RtsFilter *filter, const void *records, size_t count, uint64_t *bitmap);
+RTS_EXTERN size_t rts_filter_indices(const RtsFilter *filter, const void *records, size_t count, size_t *indices);
+
+typedef void (*RtsJobFn)(void *arg, size_t job);
+typedef void (*RtsExecuteFn)(void *context, size_t jobs, RtsJobFn fn, void *arg);
+
+typedef struct _RtsExecutor {
+    RtsExecuteFn execute;
+    void *context;
+} RtsExecutor;
+
+typedef struct _RtsPool RtsPool;
+
+typedef void (*RtsChunkFn)(void *arg, void *records, size_t first, size_t count);
+
+RTS_EXTERN RtsStatus rts_pool_create(RtsPool **pool, size_t threads);
+RTS_EXTERN void rts_pool_destroy(RtsPool *pool);
+RTS_EXTERN RtsExecutor rts_pool_executor(RtsPool *pool);
+RTS_EXTERN RtsStatus rts_parallel_for(const RtsExecutor *executor, const RtsType *type, void *records, size_t count,
+                                      RtsChunkFn fn, void *arg);
+RTS_EXTERN void rts_filter_bitmap_parallel(const RtsFilter *filter, const void *records, size_t count,
+                                           uint64_t *bitmap, const RtsExecutor *executor);
+
+typedef struct _RtsSwap {
+    struct _RtsSwapRun *runs;
+    size_t num_runs;
+    size_t stride;
+    unsigned char *masks;
+    size_t block;
+} RtsSwap;
+
+RTS_EXTERN RtsStatus rts_swap_compile(RtsSwap *swap, const RtsType *type);
+RTS_EXTERN void rts_swap_free(RtsSwap *swap);
+RTS_EXTERN void rts_swap(const RtsSwap *swap, void *dst, const void *src, size_t count);
+RTS_EXTERN void rts_swap_parallel(const RtsSwap *swap, void *dst, const void *src, size_t count,
+                                  const RtsExecutor *executor);
+
+typedef struct _RtsField {
+    const RtsType *type;
+    const RtsType *parent;
+    size_t index;
+    size_t depth;
+    size_t offset;
+    bool straddles;
+    bool hot;
+} RtsField;
+
+typedef struct _RtsHole {
+    size_t offset;
+    size_t size;
+} RtsHole;
+
+typedef struct _RtsLayout {
+    size_t size;
+    size_t padding;
+    double padding_ratio;
+    size_t lines;
+    RtsField *fields;
+    size_t num_fields;
+    size_t num_straddling;
+    RtsHole *holes;
+    size_t num_holes;
+    size_t hot_size;
+    size_t hot_lines;
+    size_t hot_lines_packed;
+} RtsLayout;
+
+RTS_EXTERN RtsStatus rts_layout_inspect(RtsLayout *layout, const RtsType *type, const double *frequencies);
+RTS_EXTERN void rts_layout_free(RtsLayout *layout);
+
+typedef enum _RtsStat {
+    RTS_STAT_LAYOUT_CALLS,
+    RTS_STAT_LAYOUT_ELEMENTS,
+    RTS_STAT_LAYOUT_NANOSECONDS,
+    RTS_STAT_VIEW_BYTES,
+    RTS_STAT_FILTER_BYTES,
+    RTS_STAT_SWAP_BYTES,
+    RTS_STAT_RECORD_BYTES,
+    RTS_STAT_CHUNKS,
+    RTS_STAT_COUNT
+} RtsStat;
+
+typedef struct _RtsStats {
+    uint64_t counters[RTS_STAT_COUNT];
+} RtsStats;
+
+RTS_EXTERN RtsStatus rts_stats_thread(RtsStats *stats);
+RTS_EXTERN RtsStatus rts_stats_global(RtsStats *stats);
+
+typedef struct _RtsRecordIter {
+    const RtsType *type;
+    size_t header;
+    size_t alignment;
+    const RtsType *count_type;
+    size_t count_offset;
+    size_t element_size;
+    const unsigned char *cursor;
+    const unsigned char *end;
+    RtsStatus status;
+} RtsRecordIter;
+
+RTS_EXTERN RtsStatus rts_record_size(const RtsType *type, const void *record, size_t *size);
+RTS_EXTERN void rts_record_iter_init(RtsRecordIter *iter, const RtsType *type, const void *buffer, size_t length);
+RTS_EXTERN const void *rts_record_iter_next(RtsRecordIter *iter, size_t *size);
 
 #endif /* LIBRTS_H */
\ No newline at end of file
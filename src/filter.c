@@ -0,0 +1,588 @@
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rts/rts.h>
+
+#include "internal.h"
+
+// Deepest stack of intermediate results a compiled program may need.
+// Chains of a single operator like `a AND b AND c` use one slot however
+// they are nested. Mixed chains like `(a OR b) AND c` only use one slot
+// when they nest to the left, as every operand of another operator
+// nested to the right takes a slot of its own.
+#define RTS_FILTER_MAX_DEPTH 16
+
+#define RTS_FILTER_WORD_BITS 64
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define RTS_FILTER_SSE2
+#include <emmintrin.h>
+#endif
+
+typedef uint64_t (*RtsFilterKernel)(const unsigned char *records, size_t stride, size_t count,
+                                    RtsFilterValue value);
+
+typedef enum _RtsFilterMode {
+    RTS_FILTER_MODE_PUSH,
+    RTS_FILTER_MODE_AND,
+    RTS_FILTER_MODE_OR,
+} RtsFilterMode;
+
+// A compare instruction evaluates `kernel` over a word of records and
+// either pushes the result or folds it into the top of the stack.
+// Instructions without a kernel fold the top two stack slots instead.
+typedef struct _RtsFilterInsn {
+    RtsFilterKernel kernel;
+    size_t offset;
+    RtsFilterValue value;
+    RtsFilterMode mode;
+} RtsFilterInsn;
+
+static uint64_t rts_filter_mask(size_t count) {
+    return count == RTS_FILTER_WORD_BITS ? ~(uint64_t) 0 : ((uint64_t) 1 << count) - 1;
+}
+
+// Compares the field never passes or always passes
+static uint64_t rts_filter_false(const unsigned char *records, size_t stride, size_t count,
+                                 RtsFilterValue value) {
+    return 0;
+}
+
+static uint64_t rts_filter_true(const unsigned char *records, size_t stride, size_t count,
+                                RtsFilterValue value) {
+    return rts_filter_mask(count);
+}
+
+// Constants are narrowed to the field type when the filter is compiled,
+// so every kernel compares at the width of the field itself.
+#define RTS_FILTER_KERNEL(name, ctype, member, opname, OP)                          \
+    static uint64_t rts_filter_##name##_##opname(const unsigned char *records,      \
+            size_t stride, size_t count, RtsFilterValue value) {                   \
+        ctype c = (ctype) value.member;                                             \
+        uint64_t bits = 0;                                                          \
+        for (size_t j = 0; j < count; j++) {                                        \
+            ctype v;                                                                \
+            memcpy(&v, records + j * stride, sizeof(v));                            \
+            bits |= (uint64_t) (v OP c) << j;                                       \
+        }                                                                           \
+        return bits;                                                                \
+    }
+
+#define RTS_FILTER_KERNELS(name, ctype, member)                                     \
+    RTS_FILTER_KERNEL(name, ctype, member, eq, ==)                                  \
+    RTS_FILTER_KERNEL(name, ctype, member, ne, !=)                                  \
+    RTS_FILTER_KERNEL(name, ctype, member, lt, <)                                   \
+    RTS_FILTER_KERNEL(name, ctype, member, le, <=)                                  \
+    RTS_FILTER_KERNEL(name, ctype, member, gt, >)                                   \
+    RTS_FILTER_KERNEL(name, ctype, member, ge, >=)
+
+#define RTS_FILTER_ROW(name) {                                                      \
+        rts_filter_##name##_eq, rts_filter_##name##_ne,                             \
+        rts_filter_##name##_lt, rts_filter_##name##_le,                             \
+        rts_filter_##name##_gt, rts_filter_##name##_ge                              \
+    }
+
+#ifdef RTS_FILTER_SSE2
+
+// The SSE2 kernels gather the field of every record in the word into a
+// dense array, unless the records are nothing but the field, and then
+// compare a whole vector of fields at a time. SSE2 has no 64-bit integer
+// compares, so 64-bit integer fields keep the scalar kernels.
+#define RTS_FILTER_SSE2_KERNEL(name, ctype, member, vtype, lanes, SET1, LOAD, CMP, MOVEMASK, opname) \
+    static uint64_t rts_filter_##name##_##opname(const unsigned char *records,      \
+            size_t stride, size_t count, RtsFilterValue value) {                   \
+        ctype dense[RTS_FILTER_WORD_BITS];                                          \
+        const unsigned char *fields = records;                                      \
+        if (stride != sizeof(ctype) || count < RTS_FILTER_WORD_BITS) {              \
+            for (size_t j = 0; j < count; j++) {                                    \
+                memcpy(&dense[j], records + j * stride, sizeof(ctype));             \
+            }                                                                       \
+            for (size_t j = count; j < RTS_FILTER_WORD_BITS; j++) {                 \
+                dense[j] = 0;                                                       \
+            }                                                                       \
+            fields = (const unsigned char *) dense;                                 \
+        }                                                                           \
+        vtype c = SET1((ctype) value.member);                                       \
+        uint64_t bits = 0;                                                          \
+        for (size_t j = 0; j < RTS_FILTER_WORD_BITS; j += lanes) {                  \
+            vtype v = LOAD(fields + j * sizeof(ctype));                             \
+            bits |= (uint64_t) (unsigned) MOVEMASK(CMP(v, c)) << j;                 \
+        }                                                                           \
+        return bits & rts_filter_mask(count);                                       \
+    }
+
+#define RTS_FILTER_SSE2_KERNELS(name, ctype, member, vtype, lanes, SET1, LOAD, ops, MOVEMASK) \
+    RTS_FILTER_SSE2_KERNEL(name, ctype, member, vtype, lanes, SET1, LOAD, rts_filter_##ops##_eq, MOVEMASK, eq) \
+    RTS_FILTER_SSE2_KERNEL(name, ctype, member, vtype, lanes, SET1, LOAD, rts_filter_##ops##_ne, MOVEMASK, ne) \
+    RTS_FILTER_SSE2_KERNEL(name, ctype, member, vtype, lanes, SET1, LOAD, rts_filter_##ops##_lt, MOVEMASK, lt) \
+    RTS_FILTER_SSE2_KERNEL(name, ctype, member, vtype, lanes, SET1, LOAD, rts_filter_##ops##_le, MOVEMASK, le) \
+    RTS_FILTER_SSE2_KERNEL(name, ctype, member, vtype, lanes, SET1, LOAD, rts_filter_##ops##_gt, MOVEMASK, gt) \
+    RTS_FILTER_SSE2_KERNEL(name, ctype, member, vtype, lanes, SET1, LOAD, rts_filter_##ops##_ge, MOVEMASK, ge)
+
+#define RTS_FILTER_NOT(m) _mm_xor_si128((m), _mm_set1_epi32(-1))
+
+// SSE2 only has signed integer compares
+#define RTS_FILTER_SSE2_INT_OPS(bits)                                               \
+    static __m128i rts_filter_i##bits##_eq(__m128i a, __m128i b) {                  \
+        return _mm_cmpeq_epi##bits(a, b);                                           \
+    }                                                                               \
+    static __m128i rts_filter_i##bits##_ne(__m128i a, __m128i b) {                  \
+        return RTS_FILTER_NOT(_mm_cmpeq_epi##bits(a, b));                           \
+    }                                                                               \
+    static __m128i rts_filter_i##bits##_lt(__m128i a, __m128i b) {                  \
+        return _mm_cmplt_epi##bits(a, b);                                           \
+    }                                                                               \
+    static __m128i rts_filter_i##bits##_le(__m128i a, __m128i b) {                  \
+        return RTS_FILTER_NOT(_mm_cmpgt_epi##bits(a, b));                           \
+    }                                                                               \
+    static __m128i rts_filter_i##bits##_gt(__m128i a, __m128i b) {                  \
+        return _mm_cmpgt_epi##bits(a, b);                                           \
+    }                                                                               \
+    static __m128i rts_filter_i##bits##_ge(__m128i a, __m128i b) {                  \
+        return RTS_FILTER_NOT(_mm_cmplt_epi##bits(a, b));                           \
+    }
+
+// Float compares are written out so NaN behaves as it does in C
+#define RTS_FILTER_SSE2_FLOAT_OPS(suffix, vtype)                                    \
+    static vtype rts_filter_##suffix##_eq(vtype a, vtype b) { return _mm_cmpeq_##suffix(a, b); }  \
+    static vtype rts_filter_##suffix##_ne(vtype a, vtype b) { return _mm_cmpneq_##suffix(a, b); } \
+    static vtype rts_filter_##suffix##_lt(vtype a, vtype b) { return _mm_cmplt_##suffix(a, b); }  \
+    static vtype rts_filter_##suffix##_le(vtype a, vtype b) { return _mm_cmple_##suffix(a, b); }  \
+    static vtype rts_filter_##suffix##_gt(vtype a, vtype b) { return _mm_cmpgt_##suffix(a, b); }  \
+    static vtype rts_filter_##suffix##_ge(vtype a, vtype b) { return _mm_cmpge_##suffix(a, b); }
+
+RTS_FILTER_SSE2_INT_OPS(8)
+RTS_FILTER_SSE2_INT_OPS(16)
+RTS_FILTER_SSE2_INT_OPS(32)
+RTS_FILTER_SSE2_FLOAT_OPS(ps, __m128)
+RTS_FILTER_SSE2_FLOAT_OPS(pd, __m128d)
+
+#define RTS_FILTER_LOAD(p) _mm_loadu_si128((const __m128i *) (p))
+#define RTS_FILTER_LOAD_PS(p) _mm_loadu_ps((const float *) (p))
+#define RTS_FILTER_LOAD_PD(p) _mm_loadu_pd((const double *) (p))
+
+// Unsigned fields are compared as signed ones with the sign bit flipped
+#define RTS_FILTER_LOAD_U8(p) _mm_xor_si128(RTS_FILTER_LOAD(p), _mm_set1_epi8((char) 0x80))
+#define RTS_FILTER_LOAD_U16(p) _mm_xor_si128(RTS_FILTER_LOAD(p), _mm_set1_epi16((short) 0x8000))
+#define RTS_FILTER_LOAD_U32(p) _mm_xor_si128(RTS_FILTER_LOAD(p), _mm_set1_epi32((int) 0x80000000u))
+#define RTS_FILTER_SET1_U8(c) _mm_set1_epi8((char) ((c) ^ 0x80u))
+#define RTS_FILTER_SET1_U16(c) _mm_set1_epi16((short) ((c) ^ 0x8000u))
+#define RTS_FILTER_SET1_U32(c) _mm_set1_epi32((int) ((c) ^ 0x80000000u))
+
+#define RTS_FILTER_MOVEMASK8(m) _mm_movemask_epi8(m)
+#define RTS_FILTER_MOVEMASK16(m) _mm_movemask_epi8(_mm_packs_epi16((m), _mm_setzero_si128()))
+#define RTS_FILTER_MOVEMASK32(m) _mm_movemask_ps(_mm_castsi128_ps(m))
+
+RTS_FILTER_SSE2_KERNELS(s8, int8_t, s, __m128i, 16, _mm_set1_epi8, RTS_FILTER_LOAD, i8, RTS_FILTER_MOVEMASK8)
+RTS_FILTER_SSE2_KERNELS(s16, int16_t, s, __m128i, 8, _mm_set1_epi16, RTS_FILTER_LOAD, i16, RTS_FILTER_MOVEMASK16)
+RTS_FILTER_SSE2_KERNELS(s32, int32_t, s, __m128i, 4, _mm_set1_epi32, RTS_FILTER_LOAD, i32, RTS_FILTER_MOVEMASK32)
+RTS_FILTER_SSE2_KERNELS(u8, uint8_t, u, __m128i, 16, RTS_FILTER_SET1_U8, RTS_FILTER_LOAD_U8, i8,
+                        RTS_FILTER_MOVEMASK8)
+RTS_FILTER_SSE2_KERNELS(u16, uint16_t, u, __m128i, 8, RTS_FILTER_SET1_U16, RTS_FILTER_LOAD_U16, i16,
+                        RTS_FILTER_MOVEMASK16)
+RTS_FILTER_SSE2_KERNELS(u32, uint32_t, u, __m128i, 4, RTS_FILTER_SET1_U32, RTS_FILTER_LOAD_U32, i32,
+                        RTS_FILTER_MOVEMASK32)
+RTS_FILTER_SSE2_KERNELS(f32, float, f, __m128, 4, _mm_set1_ps, RTS_FILTER_LOAD_PS, ps, _mm_movemask_ps)
+RTS_FILTER_SSE2_KERNELS(f64, double, f, __m128d, 2, _mm_set1_pd, RTS_FILTER_LOAD_PD, pd, _mm_movemask_pd)
+
+#else
+
+RTS_FILTER_KERNELS(s8, int8_t, s)
+RTS_FILTER_KERNELS(s16, int16_t, s)
+RTS_FILTER_KERNELS(s32, int32_t, s)
+RTS_FILTER_KERNELS(u8, uint8_t, u)
+RTS_FILTER_KERNELS(u16, uint16_t, u)
+RTS_FILTER_KERNELS(u32, uint32_t, u)
+RTS_FILTER_KERNELS(f32, float, f)
+RTS_FILTER_KERNELS(f64, double, f)
+
+#endif /* RTS_FILTER_SSE2 */
+
+RTS_FILTER_KERNELS(s64, int64_t, s)
+RTS_FILTER_KERNELS(u64, uint64_t, u)
+RTS_FILTER_KERNELS(fld, long double, f)
+
+typedef enum _RtsFilterKind {
+    RTS_FILTER_KIND_S8,
+    RTS_FILTER_KIND_S16,
+    RTS_FILTER_KIND_S32,
+    RTS_FILTER_KIND_S64,
+    RTS_FILTER_KIND_U8,
+    RTS_FILTER_KIND_U16,
+    RTS_FILTER_KIND_U32,
+    RTS_FILTER_KIND_U64,
+    RTS_FILTER_KIND_F32,
+    RTS_FILTER_KIND_F64,
+    RTS_FILTER_KIND_FLD,
+    RTS_FILTER_KIND_NONE,
+} RtsFilterKind;
+
+static const RtsFilterKernel rts_filter_kernels[][6] = {
+    RTS_FILTER_ROW(s8),
+    RTS_FILTER_ROW(s16),
+    RTS_FILTER_ROW(s32),
+    RTS_FILTER_ROW(s64),
+    RTS_FILTER_ROW(u8),
+    RTS_FILTER_ROW(u16),
+    RTS_FILTER_ROW(u32),
+    RTS_FILTER_ROW(u64),
+    RTS_FILTER_ROW(f32),
+    RTS_FILTER_ROW(f64),
+    RTS_FILTER_ROW(fld),
+};
+
+static RtsFilterKind rts_filter_int_kind(size_t size, bool is_signed) {
+    RtsFilterKind base = is_signed ? RTS_FILTER_KIND_S8 : RTS_FILTER_KIND_U8;
+    switch (size) {
+        case 1: return base;
+        case 2: return base + 1;
+        case 4: return base + 2;
+        case 8: return base + 3;
+        default: return RTS_FILTER_KIND_NONE;
+    }
+}
+
+static RtsFilterKind rts_filter_kind(const RtsType *type) {
+    switch (type->tag) {
+        case RTS_TYPE_TAG_CHAR:
+            return rts_filter_int_kind(type->size, CHAR_MIN < 0);
+        case RTS_TYPE_TAG_SINT:
+        case RTS_TYPE_TAG_SCHAR:
+        case RTS_TYPE_TAG_SSHORT:
+        case RTS_TYPE_TAG_SLONG:
+        case RTS_TYPE_TAG_SLONGLONG:
+        case RTS_TYPE_TAG_SINT8:
+        case RTS_TYPE_TAG_SINT16:
+        case RTS_TYPE_TAG_SINT32:
+        case RTS_TYPE_TAG_SINT64:
+            return rts_filter_int_kind(type->size, true);
+        case RTS_TYPE_TAG_UINT:
+        case RTS_TYPE_TAG_UCHAR:
+        case RTS_TYPE_TAG_USHORT:
+        case RTS_TYPE_TAG_ULONG:
+        case RTS_TYPE_TAG_ULONGLONG:
+        case RTS_TYPE_TAG_UINT8:
+        case RTS_TYPE_TAG_UINT16:
+        case RTS_TYPE_TAG_UINT32:
+        case RTS_TYPE_TAG_UINT64:
+        case RTS_TYPE_TAG_POINTER:
+            return rts_filter_int_kind(type->size, false);
+        case RTS_TYPE_TAG_FLOAT:
+            return RTS_FILTER_KIND_F32;
+        case RTS_TYPE_TAG_DOUBLE:
+            return RTS_FILTER_KIND_F64;
+        case RTS_TYPE_TAG_LONGDOUBLE:
+            return RTS_FILTER_KIND_FLD;
+        default:
+            return RTS_FILTER_KIND_NONE;
+    }
+}
+
+typedef enum _RtsFilterFold {
+    RTS_FILTER_FOLD_NONE,
+    RTS_FILTER_FOLD_FALSE,
+    RTS_FILTER_FOLD_TRUE,
+} RtsFilterFold;
+
+// Compares against a constant the field can never hold have the same
+// result for every record
+static RtsFilterFold rts_filter_fold_range(RtsFilterOp op, int side) {
+    if (side == 0) {
+        return RTS_FILTER_FOLD_NONE;
+    }
+    switch (op) {
+        case RTS_FILTER_OP_NE: return RTS_FILTER_FOLD_TRUE;
+        case RTS_FILTER_OP_LT:
+        case RTS_FILTER_OP_LE: return side > 0 ? RTS_FILTER_FOLD_TRUE : RTS_FILTER_FOLD_FALSE;
+        case RTS_FILTER_OP_GT:
+        case RTS_FILTER_OP_GE: return side < 0 ? RTS_FILTER_FOLD_TRUE : RTS_FILTER_FOLD_FALSE;
+        default: return RTS_FILTER_FOLD_FALSE;
+    }
+}
+
+// Closest float to `f` in the given direction
+static float rts_filter_float_step(float f, bool up) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    if (f == 0.0f) {
+        bits = up ? 1 : 0x80000001u;
+    } else if ((f > 0.0f) == up) {
+        bits++;
+    } else {
+        bits--;
+    }
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Rewrites a compare so its constant fits the field type exactly. A double
+// between two floats is replaced by the float on the side the compare
+// looks at, and integers outside of the field range fold to a constant.
+static RtsFilterFold rts_filter_narrow(RtsFilterKind kind, RtsFilterOp *op, RtsFilterValue *value) {
+    static const int64_t mins[] = {INT8_MIN, INT16_MIN, INT32_MIN, INT64_MIN};
+    static const int64_t maxs[] = {INT8_MAX, INT16_MAX, INT32_MAX, INT64_MAX};
+    static const uint64_t umaxs[] = {UINT8_MAX, UINT16_MAX, UINT32_MAX, UINT64_MAX};
+    if (kind >= RTS_FILTER_KIND_S8 && kind <= RTS_FILTER_KIND_S64) {
+        size_t i = kind - RTS_FILTER_KIND_S8;
+        return rts_filter_fold_range(*op, value->s < mins[i] ? -1 : value->s > maxs[i]);
+    }
+    if (kind >= RTS_FILTER_KIND_U8 && kind <= RTS_FILTER_KIND_U64) {
+        return rts_filter_fold_range(*op, value->u > umaxs[kind - RTS_FILTER_KIND_U8]);
+    }
+    if (kind != RTS_FILTER_KIND_F32) {
+        return RTS_FILTER_FOLD_NONE;
+    }
+    double c = value->f;
+    if (c != c) { // Only != holds for NaN
+        return *op == RTS_FILTER_OP_NE ? RTS_FILTER_FOLD_TRUE : RTS_FILTER_FOLD_FALSE;
+    }
+    float f = c > FLT_MAX ? INFINITY : c < -FLT_MAX ? -INFINITY : (float) c;
+    if ((double) f == c) {
+        return RTS_FILTER_FOLD_NONE;
+    }
+    float below = (double) f > c ? rts_filter_float_step(f, false) : f;
+    float above = (double) f < c ? rts_filter_float_step(f, true) : f;
+    switch (*op) {
+        case RTS_FILTER_OP_EQ: return RTS_FILTER_FOLD_FALSE;
+        case RTS_FILTER_OP_NE: return RTS_FILTER_FOLD_TRUE;
+        case RTS_FILTER_OP_LT:
+        case RTS_FILTER_OP_LE:
+            *op = RTS_FILTER_OP_LE;
+            value->f = below;
+            break;
+        default:
+            *op = RTS_FILTER_OP_GE;
+            value->f = above;
+            break;
+    }
+    return RTS_FILTER_FOLD_NONE;
+}
+
+static bool rts_filter_is_leaf(const RtsFilterExpr *expr) {
+    return expr->op != RTS_FILTER_OP_AND && expr->op != RTS_FILTER_OP_OR;
+}
+
+static size_t rts_filter_count(const RtsFilterExpr *expr) {
+    if (expr == NULL) {
+        return 0;
+    }
+    if (rts_filter_is_leaf(expr)) {
+        return 1;
+    }
+    return 1 + rts_filter_count(expr->lhs) + rts_filter_count(expr->rhs);
+}
+
+typedef struct _RtsFilterCompiler {
+    const RtsType *type;
+    size_t num_fields;
+    RtsFilterInsn *program;
+    size_t length;
+    size_t depth;
+    size_t max_depth;
+} RtsFilterCompiler;
+
+static RtsStatus rts_filter_emit_leaf(RtsFilterCompiler *compiler, const RtsFilterExpr *expr,
+                                      RtsFilterMode mode) {
+    if (expr->op > RTS_FILTER_OP_GE || expr->field >= compiler->num_fields) {
+        return RTS_STATUS_BAD_EXPRESSION;
+    }
+    const RtsType *type = compiler->type;
+    RtsFilterKind kind = rts_filter_kind(type->elements[expr->field]);
+    if (kind == RTS_FILTER_KIND_NONE) {
+        return RTS_STATUS_BAD_EXPRESSION;
+    }
+    RtsFilterOp op = expr->op;
+    RtsFilterInsn *insn = &compiler->program[compiler->length++];
+    insn->offset = type->tag == RTS_TYPE_TAG_UNION ? 0 : type->offsets[expr->field];
+    insn->value = expr->value;
+    insn->mode = mode;
+    switch (rts_filter_narrow(kind, &op, &insn->value)) {
+        case RTS_FILTER_FOLD_NONE: insn->kernel = rts_filter_kernels[kind][op]; break;
+        case RTS_FILTER_FOLD_FALSE: insn->kernel = rts_filter_false; break;
+        case RTS_FILTER_FOLD_TRUE: insn->kernel = rts_filter_true; break;
+    }
+    if (mode == RTS_FILTER_MODE_PUSH && ++compiler->depth > compiler->max_depth) {
+        compiler->max_depth = compiler->depth;
+    }
+    return RTS_STATUS_OK;
+}
+
+static RtsStatus rts_filter_emit(RtsFilterCompiler *compiler, const RtsFilterExpr *expr);
+
+static RtsFilterMode rts_filter_mode(const RtsFilterExpr *expr) {
+    return expr->op == RTS_FILTER_OP_AND ? RTS_FILTER_MODE_AND : RTS_FILTER_MODE_OR;
+}
+
+// Folds `expr` into the result on top of the stack. AND and OR are
+// associative, so operands of the same operator fold in one at a time
+// rather than being evaluated into a slot of their own first.
+static RtsStatus rts_filter_fold(RtsFilterCompiler *compiler, const RtsFilterExpr *expr, RtsFilterMode mode) {
+    if (expr == NULL) {
+        return RTS_STATUS_BAD_EXPRESSION;
+    }
+    if (rts_filter_is_leaf(expr)) {
+        return rts_filter_emit_leaf(compiler, expr, mode);
+    }
+    RtsStatus status;
+    if (rts_filter_mode(expr) == mode) {
+        status = rts_filter_fold(compiler, expr->lhs, mode);
+        return status != RTS_STATUS_OK ? status : rts_filter_fold(compiler, expr->rhs, mode);
+    }
+    status = rts_filter_emit(compiler, expr);
+    if (status == RTS_STATUS_OK) {
+        RtsFilterInsn *insn = &compiler->program[compiler->length++];
+        memset(insn, 0, sizeof(*insn));
+        insn->mode = mode;
+        compiler->depth--;
+    }
+    return status;
+}
+
+static RtsStatus rts_filter_emit(RtsFilterCompiler *compiler, const RtsFilterExpr *expr) {
+    if (expr == NULL) {
+        return RTS_STATUS_BAD_EXPRESSION;
+    }
+    if (rts_filter_is_leaf(expr)) {
+        return rts_filter_emit_leaf(compiler, expr, RTS_FILTER_MODE_PUSH);
+    }
+    RtsStatus status = rts_filter_emit(compiler, expr->lhs);
+    return status != RTS_STATUS_OK ? status : rts_filter_fold(compiler, expr->rhs, rts_filter_mode(expr));
+}
+
+RtsStatus rts_filter_compile(RtsFilter *filter, const RtsType *type, const RtsFilterExpr *expr) {
+    if (filter == NULL || type == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    filter->program = NULL;
+    filter->length = 0;
+    filter->stride = type->size;
+    if ((type->tag != RTS_TYPE_TAG_STRUCT && type->tag != RTS_TYPE_TAG_UNION) ||
+            type->elements == NULL || type->size == 0 || rts_type_is_variable(type)) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    if (expr == NULL) {
+        return RTS_STATUS_BAD_EXPRESSION;
+    }
+
+    RtsFilterCompiler compiler;
+    compiler.type = type;
+    compiler.num_fields = 0;
+    while (type->elements[compiler.num_fields] != NULL) {
+        compiler.num_fields++;
+    }
+    compiler.program = malloc(rts_filter_count(expr) * sizeof(RtsFilterInsn));
+    if (compiler.program == NULL) {
+        return RTS_STATUS_NO_MEMORY;
+    }
+    compiler.length = 0;
+    compiler.depth = 0;
+    compiler.max_depth = 0;
+
+    RtsStatus status = rts_filter_emit(&compiler, expr);
+    if (status == RTS_STATUS_OK && compiler.max_depth > RTS_FILTER_MAX_DEPTH) {
+        status = RTS_STATUS_BAD_EXPRESSION;
+    }
+    if (status != RTS_STATUS_OK) {
+        free(compiler.program);
+        return status;
+    }
+    filter->program = compiler.program;
+    filter->length = compiler.length;
+    return RTS_STATUS_OK;
+}
+
+void rts_filter_free(RtsFilter *filter) {
+    if (filter == NULL) {
+        return;
+    }
+    free(filter->program);
+    filter->program = NULL;
+    filter->length = 0;
+}
+
+static uint64_t rts_filter_word(const RtsFilter *filter, const unsigned char *records, size_t count) {
+    uint64_t stack[RTS_FILTER_MAX_DEPTH];
+    size_t top = 0;
+    for (size_t i = 0; i < filter->length; i++) {
+        const RtsFilterInsn *insn = &filter->program[i];
+        uint64_t bits;
+        if (insn->kernel != NULL) {
+            bits = insn->kernel(records + insn->offset, filter->stride, count, insn->value);
+        } else {
+            bits = stack[--top];
+        }
+        switch (insn->mode) {
+            case RTS_FILTER_MODE_PUSH: stack[top++] = bits; break;
+            case RTS_FILTER_MODE_AND: stack[top - 1] &= bits; break;
+            case RTS_FILTER_MODE_OR: stack[top - 1] |= bits; break;
+        }
+    }
+    return stack[0];
+}
+
+static size_t rts_filter_ctz(uint64_t bits) {
+#ifdef __GNUC__
+    return (size_t) __builtin_ctzll(bits);
+#else
+    size_t bit = 0;
+    while (!(bits & ((uint64_t) 1 << bit))) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Every bitmap word only depends on its own 64 records, so callers may split
+// a buffer at any multiple of 64 records and filter the pieces concurrently.
+void rts_filter_bitmap(const RtsFilter *filter, const void *records, size_t count, uint64_t *bitmap) {
+    RTS_STATS_ADD(RTS_STAT_FILTER_BYTES, count * filter->stride);
+    RTS_PROBE2(filter, records, count);
+    const unsigned char *cursor = records;
+    size_t word_stride = filter->stride * RTS_FILTER_WORD_BITS;
+    for (size_t i = 0; i < count; i += RTS_FILTER_WORD_BITS) {
+        size_t n = count - i < RTS_FILTER_WORD_BITS ? count - i : RTS_FILTER_WORD_BITS;
+        *bitmap++ = rts_filter_word(filter, cursor, n);
+        cursor += word_stride;
+    }
+}
+
+size_t rts_filter_indices(const RtsFilter *filter, const void *records, size_t count, size_t *indices) {
+    RTS_STATS_ADD(RTS_STAT_FILTER_BYTES, count * filter->stride);
+    RTS_PROBE2(filter, records, count);
+    const unsigned char *cursor = records;
+    size_t word_stride = filter->stride * RTS_FILTER_WORD_BITS;
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i += RTS_FILTER_WORD_BITS) {
+        size_t n = count - i < RTS_FILTER_WORD_BITS ? count - i : RTS_FILTER_WORD_BITS;
+        uint64_t bits = rts_filter_word(filter, cursor, n);
+        while (bits != 0) {
+            indices[matches++] = i + rts_filter_ctz(bits);
+            bits &= bits - 1;
+        }
+        cursor += word_stride;
+    }
+    return matches;
+}
+
+typedef struct _RtsFilterChunks {
+    const RtsFilter *filter;
+    uint64_t *bitmap;
+} RtsFilterChunks;
+
+static void rts_filter_chunk(void *arg, void *records, size_t first, size_t count) {
+    RtsFilterChunks *chunks = arg;
+    rts_filter_bitmap(chunks->filter, records, count, chunks->bitmap + first / RTS_FILTER_WORD_BITS);
+}
+
+void rts_filter_bitmap_parallel(const RtsFilter *filter, const void *records, size_t count,
+                                uint64_t *bitmap, const RtsExecutor *executor) {
+    RtsFilterChunks chunks = {filter, bitmap};
+    rts_parallel_chunks(executor, filter->stride, (void *) records, count, RTS_FILTER_WORD_BITS,
+                        rts_filter_chunk, &chunks);
+}
@@ -0,0 +1,66 @@
+#ifndef LIBRTS_INTERNAL_H
+#define LIBRTS_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rts/rts.h>
+
+#ifdef RTS_WITH_PROBES
+#include <sys/sdt.h>
+#endif
+
+// Bulk operations hand out work in chunks of roughly this many bytes,
+// small enough to stay resident in a core's L2 cache.
+#define RTS_CHUNK_BYTES ((size_t) 256 * 1024)
+
+// Like rts_parallel_for, but every chunk except the last holds a multiple
+// of `multiple` records.
+void rts_parallel_chunks(const RtsExecutor *executor, size_t stride, void *records, size_t count,
+                         size_t multiple, RtsChunkFn fn, void *arg);
+
+#ifdef RTS_WITH_STATS
+
+typedef struct _RtsStatsNode {
+    uint64_t counters[RTS_STAT_COUNT];
+    struct _RtsStatsNode *prev;
+    struct _RtsStatsNode *next;
+} RtsStatsNode;
+
+extern __thread RtsStatsNode *rts_stats_node;
+
+RtsStatsNode *rts_stats_register(void);
+uint64_t rts_stats_clock(void);
+
+// Only the owning thread writes its counters. The relaxed store lets
+// snapshots read them from other threads without a locked instruction.
+static inline void rts_stats_add(RtsStat stat, uint64_t n) {
+    RtsStatsNode *node = rts_stats_node;
+    if (node == NULL) {
+        node = rts_stats_register();
+        if (node == NULL) {
+            return;
+        }
+    }
+    __atomic_store_n(&node->counters[stat], node->counters[stat] + n, __ATOMIC_RELAXED);
+}
+
+#define RTS_STATS_ADD(stat, n) rts_stats_add((stat), (n))
+#define RTS_STATS_CLOCK() rts_stats_clock()
+
+#else
+
+#define RTS_STATS_ADD(stat, n) ((void) sizeof(n))
+#define RTS_STATS_CLOCK() ((uint64_t) 0)
+
+#endif /* RTS_WITH_STATS */
+
+#ifdef RTS_WITH_PROBES
+#define RTS_PROBE1(name, a) DTRACE_PROBE1(rts, name, a)
+#define RTS_PROBE2(name, a, b) DTRACE_PROBE2(rts, name, a, b)
+#else
+#define RTS_PROBE1(name, a) ((void) 0)
+#define RTS_PROBE2(name, a, b) ((void) 0)
+#endif
+
+#endif /* LIBRTS_INTERNAL_H */
@@ -0,0 +1,206 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rts/rts.h>
+
+static bool rts_layout_is_aggregate(const RtsType *type) {
+    return type->tag == RTS_TYPE_TAG_STRUCT || type->tag == RTS_TYPE_TAG_UNION;
+}
+
+static size_t rts_layout_count(const RtsType *type) {
+    size_t count = 0;
+    for (size_t i = 0; type->elements[i] != NULL; i++) {
+        RtsType *element = type->elements[i];
+        count += 1 + (rts_layout_is_aggregate(element) ? rts_layout_count(element) : 0);
+    }
+    return count;
+}
+
+static size_t rts_layout_gcd(size_t a, size_t b) {
+    while (b != 0) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Checks every position a record can start at within a cache line when
+// records are packed back to back, not just a record at offset zero.
+static bool rts_layout_straddles(size_t stride, size_t offset, size_t size) {
+    if (size == 0) {
+        return false;
+    }
+    size_t step = rts_layout_gcd(stride, RTS_CACHE_LINE_SIZE);
+    for (size_t base = 0; base < RTS_CACHE_LINE_SIZE; base += step) {
+        size_t start = base + offset;
+        if (start / RTS_CACHE_LINE_SIZE != (start + size - 1) / RTS_CACHE_LINE_SIZE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct _RtsLayoutWalk {
+    RtsLayout *layout;
+    unsigned char *covered;
+} RtsLayoutWalk;
+
+static void rts_layout_walk(RtsLayoutWalk *walk, const RtsType *type, size_t offset, size_t depth) {
+    RtsLayout *layout = walk->layout;
+    bool is_union = type->tag == RTS_TYPE_TAG_UNION;
+    for (size_t i = 0; type->elements[i] != NULL; i++) {
+        const RtsType *element = type->elements[i];
+        RtsField *field = &layout->fields[layout->num_fields++];
+        field->type = element;
+        field->parent = type;
+        field->index = i;
+        field->depth = depth;
+        field->offset = offset + (is_union ? 0 : type->offsets[i]);
+        field->straddles = rts_layout_straddles(layout->size, field->offset, element->size);
+        field->hot = false;
+        layout->num_straddling += field->straddles;
+        if (rts_layout_is_aggregate(element)) {
+            rts_layout_walk(walk, element, field->offset, depth + 1);
+        } else {
+            for (size_t b = 0; b < element->size; b++) {
+                walk->covered[field->offset + b] = 1;
+            }
+        }
+    }
+}
+
+static RtsStatus rts_layout_holes(RtsLayout *layout, const unsigned char *covered) {
+    size_t num_holes = 0;
+    for (size_t b = 0; b < layout->size; b++) {
+        if (!covered[b]) {
+            layout->padding++;
+            num_holes += b == 0 || covered[b - 1];
+        }
+    }
+    if (num_holes == 0) {
+        return RTS_STATUS_OK;
+    }
+    layout->holes = malloc(num_holes * sizeof(RtsHole));
+    if (layout->holes == NULL) {
+        return RTS_STATUS_NO_MEMORY;
+    }
+    for (size_t b = 0; b < layout->size; b++) {
+        if (covered[b]) {
+            continue;
+        }
+        if (b == 0 || covered[b - 1]) {
+            RtsHole *hole = &layout->holes[layout->num_holes++];
+            hole->offset = b;
+            hole->size = 0;
+        }
+        layout->holes[layout->num_holes - 1].size++;
+    }
+    return RTS_STATUS_OK;
+}
+
+// Fields accessed at least as often as the average scalar field are hot.
+// Hot bytes are counted once where union members overlap.
+static RtsStatus rts_layout_hot(RtsLayout *layout, const double *frequencies) {
+    double total = 0.0;
+    size_t scalars = 0;
+    for (size_t i = 0; i < layout->num_fields; i++) {
+        if (!rts_layout_is_aggregate(layout->fields[i].type)) {
+            total += frequencies[i];
+            scalars++;
+        }
+    }
+    if (scalars == 0 || total <= 0.0) {
+        return RTS_STATUS_OK;
+    }
+    double mean = total / scalars;
+    unsigned char *hot = calloc(layout->size, 1);
+    if (hot == NULL) {
+        return RTS_STATUS_NO_MEMORY;
+    }
+    for (size_t i = 0; i < layout->num_fields; i++) {
+        RtsField *field = &layout->fields[i];
+        if (rts_layout_is_aggregate(field->type) || frequencies[i] <= 0.0 || frequencies[i] < mean) {
+            continue;
+        }
+        field->hot = true;
+        memset(hot + field->offset, 1, field->type->size);
+    }
+    size_t next_line = 0;
+    for (size_t b = 0; b < layout->size; b++) {
+        if (!hot[b]) {
+            continue;
+        }
+        layout->hot_size++;
+        if (b / RTS_CACHE_LINE_SIZE >= next_line) {
+            layout->hot_lines++;
+            next_line = b / RTS_CACHE_LINE_SIZE + 1;
+        }
+    }
+    free(hot);
+    layout->hot_lines_packed = (layout->hot_size + RTS_CACHE_LINE_SIZE - 1) / RTS_CACHE_LINE_SIZE;
+    return RTS_STATUS_OK;
+}
+
+RtsStatus rts_layout_inspect(RtsLayout *layout, const RtsType *type, const double *frequencies) {
+    if (layout == NULL || type == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    layout->size = type->size;
+    layout->padding = 0;
+    layout->padding_ratio = 0.0;
+    layout->lines = (type->size + RTS_CACHE_LINE_SIZE - 1) / RTS_CACHE_LINE_SIZE;
+    layout->fields = NULL;
+    layout->num_fields = 0;
+    layout->num_straddling = 0;
+    layout->holes = NULL;
+    layout->num_holes = 0;
+    layout->hot_size = 0;
+    layout->hot_lines = 0;
+    layout->hot_lines_packed = 0;
+    if (!rts_layout_is_aggregate(type) || type->elements == NULL || type->size == 0 ||
+            rts_type_is_variable(type)) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+
+    RtsLayoutWalk walk;
+    walk.layout = layout;
+    walk.covered = calloc(type->size, 1);
+    layout->fields = malloc(rts_layout_count(type) * sizeof(RtsField));
+    if (walk.covered == NULL || layout->fields == NULL) {
+        free(walk.covered);
+        rts_layout_free(layout);
+        return RTS_STATUS_NO_MEMORY;
+    }
+    rts_layout_walk(&walk, type, 0, 0);
+    RtsStatus status = rts_layout_holes(layout, walk.covered);
+    free(walk.covered);
+    if (status != RTS_STATUS_OK) {
+        rts_layout_free(layout);
+        return status;
+    }
+    layout->padding_ratio = (double) layout->padding / (double) layout->size;
+    if (frequencies != NULL) {
+        status = rts_layout_hot(layout, frequencies);
+        if (status != RTS_STATUS_OK) {
+            rts_layout_free(layout);
+            return status;
+        }
+    }
+    return RTS_STATUS_OK;
+}
+
+void rts_layout_free(RtsLayout *layout) {
+    if (layout == NULL) {
+        return;
+    }
+    free(layout->fields);
+    free(layout->holes);
+    layout->fields = NULL;
+    layout->num_fields = 0;
+    layout->holes = NULL;
+    layout->num_holes = 0;
+}
@@ -0,0 +1,257 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifdef RTS_WITH_THREADS
+#include <pthread.h>
+#endif
+
+#include <rts/rts.h>
+
+#include "internal.h"
+
+#ifdef RTS_WITH_THREADS
+
+// Workers and the submitting thread all pull job indices from a shared
+// counter, so a thread that finishes its chunks early keeps taking more
+// instead of sitting idle behind a static partition.
+struct _RtsPool {
+    pthread_t *threads;
+    size_t num_threads;
+    pthread_mutex_t submit;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    RtsJobFn fn;
+    void *arg;
+    size_t jobs;
+    size_t next;
+    size_t finished;
+    size_t active;
+    size_t generation;
+    bool stop;
+};
+
+static size_t rts_pool_take(RtsPool *pool) {
+#ifdef __GNUC__
+    return __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+#else
+    pthread_mutex_lock(&pool->lock);
+    size_t job = pool->next++;
+    pthread_mutex_unlock(&pool->lock);
+    return job;
+#endif
+}
+
+// Runs jobs until none are left, returning how many this thread ran
+static size_t rts_pool_run(RtsPool *pool, RtsJobFn fn, void *arg, size_t jobs) {
+    size_t ran = 0;
+    for (size_t job = rts_pool_take(pool); job < jobs; job = rts_pool_take(pool)) {
+        fn(arg, job);
+        ran++;
+    }
+    return ran;
+}
+
+static void *rts_pool_worker(void *data) {
+    RtsPool *pool = data;
+    size_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->generation;
+        RtsJobFn fn = pool->fn;
+        void *arg = pool->arg;
+        size_t jobs = pool->jobs;
+        pool->active++;
+        pthread_mutex_unlock(&pool->lock);
+
+        size_t ran = rts_pool_run(pool, fn, arg, jobs);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->finished += ran;
+        pool->active--;
+        if (pool->finished == pool->jobs || pool->active == 0) {
+            pthread_cond_broadcast(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void rts_pool_execute(void *context, size_t jobs, RtsJobFn fn, void *arg) {
+    RtsPool *pool = context;
+    if (pool->num_threads == 0 || jobs < 2) {
+        for (size_t job = 0; job < jobs; job++) {
+            fn(arg, job);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->submit);
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0) { // Stragglers from the last batch still read its state
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->jobs = jobs;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    size_t ran = rts_pool_run(pool, fn, arg, jobs);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->finished += ran;
+    while (pool->finished < jobs) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->submit);
+}
+
+RtsStatus rts_pool_create(RtsPool **pool, size_t threads) {
+    if (pool == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    RtsPool *p = calloc(1, sizeof(RtsPool));
+    if (p == NULL) {
+        return RTS_STATUS_NO_MEMORY;
+    }
+    if (threads > 0) {
+        p->threads = malloc(threads * sizeof(pthread_t));
+        if (p->threads == NULL) {
+            free(p);
+            return RTS_STATUS_NO_MEMORY;
+        }
+    }
+    pthread_mutex_init(&p->submit, NULL);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->work, NULL);
+    pthread_cond_init(&p->done, NULL);
+    for (size_t i = 0; i < threads; i++) {
+        if (pthread_create(&p->threads[i], NULL, rts_pool_worker, p) != 0) {
+            rts_pool_destroy(p);
+            return RTS_STATUS_NO_MEMORY;
+        }
+        p->num_threads++;
+    }
+    *pool = p;
+    return RTS_STATUS_OK;
+}
+
+void rts_pool_destroy(RtsPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->submit);
+    free(pool->threads);
+    free(pool);
+}
+
+RtsExecutor rts_pool_executor(RtsPool *pool) {
+    RtsExecutor executor = {rts_pool_execute, pool};
+    return executor;
+}
+
+#else
+
+// Without threads only a pool of zero threads can be made, which runs
+// every job in order on the calling thread
+struct _RtsPool {
+    size_t num_threads;
+};
+
+RtsStatus rts_pool_create(RtsPool **pool, size_t threads) {
+    if (pool == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    if (threads > 0) {
+        return RTS_STATUS_UNSUPPORTED;
+    }
+    RtsPool *p = calloc(1, sizeof(RtsPool));
+    if (p == NULL) {
+        return RTS_STATUS_NO_MEMORY;
+    }
+    *pool = p;
+    return RTS_STATUS_OK;
+}
+
+void rts_pool_destroy(RtsPool *pool) {
+    free(pool);
+}
+
+RtsExecutor rts_pool_executor(RtsPool *pool) {
+    RtsExecutor executor = {NULL, pool};
+    return executor;
+}
+
+#endif /* RTS_WITH_THREADS */
+
+typedef struct _RtsChunks {
+    unsigned char *records;
+    size_t stride;
+    size_t count;
+    size_t chunk;
+    RtsChunkFn fn;
+    void *arg;
+} RtsChunks;
+
+static void rts_chunks_job(void *arg, size_t job) {
+    RtsChunks *chunks = arg;
+    size_t first = job * chunks->chunk;
+    size_t left = chunks->count - first;
+    size_t count = left < chunks->chunk ? left : chunks->chunk;
+    chunks->fn(chunks->arg, chunks->records + first * chunks->stride, first, count);
+}
+
+void rts_parallel_chunks(const RtsExecutor *executor, size_t stride, void *records, size_t count,
+                         size_t multiple, RtsChunkFn fn, void *arg) {
+    if (count == 0) {
+        return;
+    }
+    size_t chunk = stride ? RTS_CHUNK_BYTES / stride : count;
+    chunk = (chunk + multiple - 1) / multiple * multiple;
+    if (chunk == 0) {
+        chunk = multiple;
+    }
+
+    RtsChunks chunks = {records, stride, count, chunk, fn, arg};
+    size_t jobs = (count + chunk - 1) / chunk;
+    RTS_STATS_ADD(RTS_STAT_CHUNKS, jobs);
+    if (executor == NULL || executor->execute == NULL) { // Deterministic, in order
+        for (size_t job = 0; job < jobs; job++) {
+            rts_chunks_job(&chunks, job);
+        }
+        return;
+    }
+    executor->execute(executor->context, jobs, rts_chunks_job, &chunks);
+}
+
+RtsStatus rts_parallel_for(const RtsExecutor *executor, const RtsType *type, void *records, size_t count,
+                           RtsChunkFn fn, void *arg) {
+    if (type == NULL || type->size == 0 || rts_type_is_variable(type)) { // Chunks of type->size would split records
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    rts_parallel_chunks(executor, type->size, records, count, 1, fn, arg);
+    return RTS_STATUS_OK;
+}
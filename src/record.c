@@ -0,0 +1,161 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <rts/rts.h>
+
+#include "internal.h"
+
+static bool rts_record_is_signed(const RtsType *type) {
+    switch (type->tag) {
+        case RTS_TYPE_TAG_CHAR:
+            return CHAR_MIN < 0;
+        case RTS_TYPE_TAG_SINT:
+        case RTS_TYPE_TAG_SCHAR:
+        case RTS_TYPE_TAG_SSHORT:
+        case RTS_TYPE_TAG_SLONG:
+        case RTS_TYPE_TAG_SLONGLONG:
+        case RTS_TYPE_TAG_SINT8:
+        case RTS_TYPE_TAG_SINT16:
+        case RTS_TYPE_TAG_SINT32:
+        case RTS_TYPE_TAG_SINT64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Reads the element count of a flexible array member, rejecting negative counts
+static RtsStatus rts_record_count(const RtsType *type, const unsigned char *field, size_t *count) {
+    uint64_t u = 0;
+    int64_t s = 0;
+    bool is_signed = rts_record_is_signed(type);
+    switch (type->size) {
+        case 1: {
+            uint8_t x;
+            memcpy(&x, field, 1);
+            u = x;
+            s = (int8_t) x;
+            break;
+        }
+        case 2: {
+            uint16_t x;
+            memcpy(&x, field, 2);
+            u = x;
+            s = (int16_t) x;
+            break;
+        }
+        case 4: {
+            uint32_t x;
+            memcpy(&x, field, 4);
+            u = x;
+            s = (int32_t) x;
+            break;
+        }
+        case 8: {
+            memcpy(&u, field, 8);
+            s = (int64_t) u;
+            break;
+        }
+        default:
+            return RTS_STATUS_BAD_TYPEDEF;
+    }
+    if (is_signed && s < 0) {
+        return RTS_STATUS_BAD_SIZE;
+    }
+    if (u > SIZE_MAX) {
+        return RTS_STATUS_BAD_SIZE;
+    }
+    *count = (size_t) u;
+    return RTS_STATUS_OK;
+}
+
+// Resolves once where the size of each record of `type` comes from, so
+// measuring a record only has to read its count field
+static void rts_record_plan(RtsRecordIter *iter, const RtsType *type) {
+    iter->type = type;
+    iter->header = type->size;
+    iter->alignment = type->alignment;
+    iter->count_type = NULL;
+    iter->count_offset = 0;
+    iter->element_size = 0;
+    if (!rts_type_is_variable(type)) {
+        return;
+    }
+    size_t last = 0;
+    while (type->elements[last + 1] != NULL) {
+        last++;
+    }
+    const RtsType *flexible = type->elements[last];
+    iter->header = type->offsets[last];
+    iter->count_type = type->elements[flexible->count_field];
+    iter->count_offset = type->offsets[flexible->count_field];
+    iter->element_size = flexible->elements[0]->size;
+}
+
+// Size of the record at `record`, which must hold at least the fixed part
+static RtsStatus rts_record_measure(const RtsRecordIter *iter, const unsigned char *record, size_t *size) {
+    if (iter->count_type == NULL) {
+        *size = iter->header;
+        return RTS_STATUS_OK;
+    }
+    size_t count;
+    RtsStatus status = rts_record_count(iter->count_type, record + iter->count_offset, &count);
+    if (status != RTS_STATUS_OK) {
+        return status;
+    }
+    if (count > (SIZE_MAX - iter->header) / iter->element_size) {
+        return RTS_STATUS_BAD_SIZE;
+    }
+    *size = iter->header + count * iter->element_size;
+    return RTS_STATUS_OK;
+}
+
+RtsStatus rts_record_size(const RtsType *type, const void *record, size_t *size) {
+    if (type == NULL || record == NULL || size == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    RtsRecordIter iter;
+    rts_record_plan(&iter, type);
+    return rts_record_measure(&iter, record, size);
+}
+
+void rts_record_iter_init(RtsRecordIter *iter, const RtsType *type, const void *buffer, size_t length) {
+    rts_record_plan(iter, type);
+    iter->cursor = buffer;
+    iter->end = iter->cursor + length;
+    iter->status = RTS_STATUS_OK;
+}
+
+// Records follow each other the way they would in an array, each one
+// starting at the next offset aligned for the record type
+const void *rts_record_iter_next(RtsRecordIter *iter, size_t *size) {
+    if (iter->status != RTS_STATUS_OK || iter->cursor == iter->end) {
+        return NULL;
+    }
+    size_t left = (size_t) (iter->end - iter->cursor);
+    size_t record_size;
+    if (left < iter->header) {
+        iter->status = RTS_STATUS_BAD_SIZE;
+        return NULL;
+    }
+    iter->status = rts_record_measure(iter, iter->cursor, &record_size);
+    if (iter->status == RTS_STATUS_OK && record_size > left) {
+        iter->status = RTS_STATUS_BAD_SIZE;
+    }
+    if (iter->status != RTS_STATUS_OK) {
+        return NULL;
+    }
+
+    const unsigned char *record = iter->cursor;
+    size_t remainder = record_size % iter->alignment;
+    size_t stride = record_size + (remainder ? iter->alignment - remainder : 0);
+    iter->cursor = stride < left ? record + stride : iter->end;
+    RTS_STATS_ADD(RTS_STAT_RECORD_BYTES, record_size);
+    if (size != NULL) {
+        *size = record_size;
+    }
+    return record;
+}
@@ -4,6 +4,8 @@
 
 #include <rts/rts.h>
 
+#include "internal.h"
+
 #define RTS_MAX(lhs, rhs) (((lhs) > (rhs))? (lhs) : (rhs))
 
 #define RTS_TYPEDEF(name, type)                     \
@@ -15,7 +17,7 @@
         RTS_TYPE_TAG_##name,                        \
         offsetof(struct _struct_align_##name, x),   \
         sizeof(type),                               \
-        NULL, NULL                                  \
+        NULL, NULL, 0                               \
     }                                               \
 
 RTS_TYPEDEF(SINT, signed int);
@@ -41,10 +43,58 @@ RTS_TYPEDEF(UINT64, uint64_t);
 RTS_TYPEDEF(SINT64, int64_t);
 RTS_TYPEDEF(POINTER, void *);
 
-RtsStatus rts_type_init(RtsType *type) {
+static bool rts_type_is_integer(const RtsType *type) {
+    switch (type->tag) {
+        case RTS_TYPE_TAG_FLOAT:
+        case RTS_TYPE_TAG_DOUBLE:
+        case RTS_TYPE_TAG_LONGDOUBLE:
+        case RTS_TYPE_TAG_POINTER:
+        case RTS_TYPE_TAG_STRUCT:
+        case RTS_TYPE_TAG_UNION:
+        case RTS_TYPE_TAG_FLEXIBLE:
+            return false;
+        default:
+            return true;
+    }
+}
+
+bool rts_type_is_variable(const RtsType *type) {
+    if (type == NULL || type->tag != RTS_TYPE_TAG_STRUCT || type->elements == NULL) {
+        return false;
+    }
+    size_t i = 0;
+    while (type->elements[i] != NULL) {
+        i++;
+    }
+    return i > 0 && type->elements[i - 1]->tag == RTS_TYPE_TAG_FLEXIBLE;
+}
+
+static RtsStatus rts_type_layout(RtsType *type);
+
+// A flexible array member takes the alignment of its element type but
+// adds nothing to the size of the struct that ends with it
+static RtsStatus rts_type_layout_flexible(RtsType *type) {
+    if (type->elements == NULL || type->elements[0] == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    RtsType *element = type->elements[0];
+    if (rts_type_layout(element) != RTS_STATUS_OK || element->size == 0 ||
+            element->tag == RTS_TYPE_TAG_FLEXIBLE || rts_type_is_variable(element)) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    type->alignment = element->alignment;
+    type->size = 0;
+    return RTS_STATUS_OK;
+}
+
+static RtsStatus rts_type_layout(RtsType *type) {
     if (type == NULL) {
         return RTS_STATUS_BAD_TYPEDEF;
     }
+    RTS_STATS_ADD(RTS_STAT_LAYOUT_CALLS, 1);
+    if (type->tag == RTS_TYPE_TAG_FLEXIBLE) {
+        return rts_type_layout_flexible(type);
+    }
     bool isUnion = type->tag == RTS_TYPE_TAG_UNION;
     if (type->tag != RTS_TYPE_TAG_STRUCT && !isUnion) {
         return RTS_STATUS_OK;
@@ -57,17 +107,27 @@ RtsStatus rts_type_init(RtsType *type) {
 
     size_t i = 0;
     size_t offset = 0;
+    size_t max_size = 0;
     size_t max_align = 0;
     RtsType *element = elements[i];
     if (element == NULL) { // Empty struct
         return RTS_STATUS_BAD_TYPEDEF;
     }
     while (element != NULL) { // Align each element
-        if (rts_type_init(element) != RTS_STATUS_OK) {
+        RTS_STATS_ADD(RTS_STAT_LAYOUT_ELEMENTS, 1);
+        if (rts_type_layout(element) != RTS_STATUS_OK || rts_type_is_variable(element)) {
             return RTS_STATUS_BAD_TYPEDEF;
         }
+        if (element->tag == RTS_TYPE_TAG_FLEXIBLE) { // Only allowed last in a struct
+            size_t count_field = element->count_field;
+            if (isUnion || elements[i + 1] != NULL || count_field >= i ||
+                    !rts_type_is_integer(elements[count_field])) {
+                return RTS_STATUS_BAD_TYPEDEF;
+            }
+        }
         size_t alignment = element->alignment;
         max_align = RTS_MAX(max_align, alignment);
+        max_size = RTS_MAX(max_size, element->size);
         if (!isUnion) {
             size_t remainder = offset % alignment;
             size_t padding = remainder ? alignment - remainder : 0;
@@ -79,6 +139,10 @@ RtsStatus rts_type_init(RtsType *type) {
         element = elements[i];
     }
 
+    if (isUnion) { // Members overlap, so only the largest counts
+        offset = max_size;
+    }
+
     // Apply trailing padding
     type->alignment = max_align;
     size_t remainder = offset % max_align;
@@ -87,6 +151,15 @@ RtsStatus rts_type_init(RtsType *type) {
     return RTS_STATUS_OK;
 }
 
+RtsStatus rts_type_init(RtsType *type) {
+    RTS_PROBE1(type_init__start, type);
+    uint64_t start = RTS_STATS_CLOCK();
+    RtsStatus status = rts_type_layout(type);
+    RTS_STATS_ADD(RTS_STAT_LAYOUT_NANOSECONDS, RTS_STATS_CLOCK() - start);
+    RTS_PROBE2(type_init__done, type, status);
+    return status;
+}
+
 RtsStatus rts_init_from_string(RtsType **type, const char *str, size_t len) {
     if (type == NULL || str == NULL || len == 0) {
         return RTS_STATUS_BAD_TYPEDEF;
@@ -0,0 +1,119 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef RTS_WITH_STATS
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include <rts/rts.h>
+
+#include "internal.h"
+
+#ifdef RTS_WITH_STATS
+
+__thread RtsStatsNode *rts_stats_node;
+
+// Live threads are linked through `rts_stats_threads`. Counters of threads
+// that have exited are folded into `rts_stats_retired`.
+static pthread_mutex_t rts_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t rts_stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t rts_stats_key;
+static RtsStatsNode *rts_stats_threads;
+static uint64_t rts_stats_retired[RTS_STAT_COUNT];
+
+static void rts_stats_retire(void *data) {
+    RtsStatsNode *node = data;
+    pthread_mutex_lock(&rts_stats_lock);
+    for (size_t i = 0; i < RTS_STAT_COUNT; i++) {
+        rts_stats_retired[i] += node->counters[i];
+    }
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        rts_stats_threads = node->next;
+    }
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    }
+    pthread_mutex_unlock(&rts_stats_lock);
+    rts_stats_node = NULL;
+    free(node);
+}
+
+static void rts_stats_init(void) {
+    pthread_key_create(&rts_stats_key, rts_stats_retire);
+}
+
+RtsStatsNode *rts_stats_register(void) {
+    pthread_once(&rts_stats_once, rts_stats_init);
+    RtsStatsNode *node = calloc(1, sizeof(RtsStatsNode));
+    if (node == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&rts_stats_lock);
+    node->next = rts_stats_threads;
+    if (rts_stats_threads != NULL) {
+        rts_stats_threads->prev = node;
+    }
+    rts_stats_threads = node;
+    pthread_mutex_unlock(&rts_stats_lock);
+    pthread_setspecific(rts_stats_key, node);
+    rts_stats_node = node;
+    return node;
+}
+
+uint64_t rts_stats_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+RtsStatus rts_stats_thread(RtsStats *stats) {
+    if (stats == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    memset(stats, 0, sizeof(RtsStats));
+    if (rts_stats_node != NULL) {
+        memcpy(stats->counters, rts_stats_node->counters, sizeof(stats->counters));
+    }
+    return RTS_STATUS_OK;
+}
+
+RtsStatus rts_stats_global(RtsStats *stats) {
+    if (stats == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    pthread_mutex_lock(&rts_stats_lock);
+    memcpy(stats->counters, rts_stats_retired, sizeof(stats->counters));
+    for (RtsStatsNode *node = rts_stats_threads; node != NULL; node = node->next) {
+        for (size_t i = 0; i < RTS_STAT_COUNT; i++) {
+            stats->counters[i] += __atomic_load_n(&node->counters[i], __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&rts_stats_lock);
+    return RTS_STATUS_OK;
+}
+
+#else
+
+RtsStatus rts_stats_thread(RtsStats *stats) {
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(RtsStats));
+    }
+    return RTS_STATUS_UNSUPPORTED;
+}
+
+RtsStatus rts_stats_global(RtsStats *stats) {
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(RtsStats));
+    }
+    return RTS_STATUS_UNSUPPORTED;
+}
+
+#endif /* RTS_WITH_STATS */
@@ -0,0 +1,278 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rts/rts.h>
+
+#include "internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RTS_SWAP_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#define RTS_SWAP_LANE 16
+
+// Largest group of records the vector path builds masks for
+#define RTS_SWAP_MAX_BLOCK (RTS_SWAP_LANE * 16)
+
+// `count` adjacent fields of `width` bytes each starting at `offset`
+typedef struct _RtsSwapRun {
+    size_t offset;
+    size_t width;
+    size_t count;
+} RtsSwapRun;
+
+static size_t rts_swap_count(const RtsType *type) {
+    if (type->tag != RTS_TYPE_TAG_STRUCT) {
+        return 1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; type->elements[i] != NULL; i++) {
+        count += rts_swap_count(type->elements[i]);
+    }
+    return count;
+}
+
+static RtsStatus rts_swap_collect(RtsSwap *swap, const RtsType *type, size_t offset) {
+    switch (type->tag) {
+        case RTS_TYPE_TAG_UNION: // The active member is unknown
+        case RTS_TYPE_TAG_LONGDOUBLE: // Not an interchange format
+        case RTS_TYPE_TAG_FLEXIBLE: // Records are not a fixed stride apart
+            return RTS_STATUS_BAD_TYPEDEF;
+        case RTS_TYPE_TAG_STRUCT:
+            for (size_t i = 0; type->elements[i] != NULL; i++) {
+                RtsStatus status = rts_swap_collect(swap, type->elements[i], offset + type->offsets[i]);
+                if (status != RTS_STATUS_OK) {
+                    return status;
+                }
+            }
+            return RTS_STATUS_OK;
+        default:
+            break;
+    }
+    size_t width = type->size;
+    if (width == 1) {
+        return RTS_STATUS_OK;
+    }
+    if (width != 2 && width != 4 && width != 8) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    if (swap->num_runs > 0) { // Merge with the previous run when adjacent
+        RtsSwapRun *last = &swap->runs[swap->num_runs - 1];
+        if (last->width == width && last->offset + last->width * last->count == offset) {
+            last->count++;
+            return RTS_STATUS_OK;
+        }
+    }
+    RtsSwapRun *run = &swap->runs[swap->num_runs++];
+    run->offset = offset;
+    run->width = width;
+    run->count = 1;
+    return RTS_STATUS_OK;
+}
+
+#ifdef RTS_SWAP_SSSE3
+
+// Builds one byte shuffle mask per 16 byte lane of a block of whole
+// records. This only works when no swapped field crosses a lane.
+static RtsStatus rts_swap_masks(RtsSwap *swap) {
+    if (!__builtin_cpu_supports("ssse3")) {
+        return RTS_STATUS_OK;
+    }
+    size_t block = swap->stride;
+    while (block % RTS_SWAP_LANE != 0) {
+        block += swap->stride;
+        if (block > RTS_SWAP_MAX_BLOCK) {
+            return RTS_STATUS_OK;
+        }
+    }
+    if (block > RTS_SWAP_MAX_BLOCK) {
+        return RTS_STATUS_OK;
+    }
+    unsigned char *masks = malloc(block);
+    if (masks == NULL) {
+        return RTS_STATUS_NO_MEMORY;
+    }
+    for (size_t i = 0; i < block; i++) {
+        masks[i] = (unsigned char) (i % RTS_SWAP_LANE);
+    }
+    for (size_t base = 0; base < block; base += swap->stride) {
+        for (size_t r = 0; r < swap->num_runs; r++) {
+            const RtsSwapRun *run = &swap->runs[r];
+            for (size_t k = 0; k < run->count; k++) {
+                size_t start = base + run->offset + k * run->width;
+                size_t lane = start / RTS_SWAP_LANE;
+                if ((start + run->width - 1) / RTS_SWAP_LANE != lane) {
+                    free(masks);
+                    return RTS_STATUS_OK;
+                }
+                for (size_t b = 0; b < run->width; b++) {
+                    masks[start + b] = (unsigned char) ((start + run->width - 1 - b) % RTS_SWAP_LANE);
+                }
+            }
+        }
+    }
+    swap->masks = masks;
+    swap->block = block;
+    return RTS_STATUS_OK;
+}
+
+// Returns how many records were swapped, always a whole number of blocks
+__attribute__((target("ssse3")))
+static size_t rts_swap_vector(const RtsSwap *swap, unsigned char *dst, const unsigned char *src, size_t count) {
+    size_t records = swap->block / swap->stride;
+    size_t blocks = count / records;
+    for (size_t i = 0; i < blocks; i++) {
+        for (size_t lane = 0; lane < swap->block; lane += RTS_SWAP_LANE) {
+            __m128i mask = _mm_loadu_si128((const __m128i *) (swap->masks + lane));
+            __m128i v = _mm_loadu_si128((const __m128i *) (src + lane));
+            _mm_storeu_si128((__m128i *) (dst + lane), _mm_shuffle_epi8(v, mask));
+        }
+        src += swap->block;
+        dst += swap->block;
+    }
+    return blocks * records;
+}
+
+#else
+
+static RtsStatus rts_swap_masks(RtsSwap *swap) {
+    return RTS_STATUS_OK;
+}
+
+#endif /* RTS_SWAP_SSSE3 */
+
+RtsStatus rts_swap_compile(RtsSwap *swap, const RtsType *type) {
+    if (swap == NULL || type == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    swap->runs = NULL;
+    swap->num_runs = 0;
+    swap->stride = type->size;
+    swap->masks = NULL;
+    swap->block = 0;
+    if (type->size == 0 || (type->tag == RTS_TYPE_TAG_STRUCT && type->elements == NULL)) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+
+    swap->runs = malloc(rts_swap_count(type) * sizeof(RtsSwapRun));
+    if (swap->runs == NULL) {
+        return RTS_STATUS_NO_MEMORY;
+    }
+    RtsStatus status = rts_swap_collect(swap, type, 0);
+    if (status == RTS_STATUS_OK && swap->num_runs > 0) {
+        status = rts_swap_masks(swap);
+    }
+    if (status != RTS_STATUS_OK) {
+        rts_swap_free(swap);
+    }
+    return status;
+}
+
+void rts_swap_free(RtsSwap *swap) {
+    if (swap == NULL) {
+        return;
+    }
+    free(swap->runs);
+    free(swap->masks);
+    swap->runs = NULL;
+    swap->num_runs = 0;
+    swap->masks = NULL;
+    swap->block = 0;
+}
+
+static uint16_t rts_bswap16(uint16_t x) {
+#ifdef __GNUC__
+    return __builtin_bswap16(x);
+#else
+    return (uint16_t) ((x >> 8) | (x << 8));
+#endif
+}
+
+static uint32_t rts_bswap32(uint32_t x) {
+#ifdef __GNUC__
+    return __builtin_bswap32(x);
+#else
+    return (x >> 24) | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000) | (x << 24);
+#endif
+}
+
+static uint64_t rts_bswap64(uint64_t x) {
+#ifdef __GNUC__
+    return __builtin_bswap64(x);
+#else
+    return ((uint64_t) rts_bswap32((uint32_t) x) << 32) | rts_bswap32((uint32_t) (x >> 32));
+#endif
+}
+
+static void rts_swap_run(const RtsSwapRun *run, unsigned char *record) {
+    unsigned char *p = record + run->offset;
+    switch (run->width) {
+        case 2:
+            for (size_t k = 0; k < run->count; k++, p += 2) {
+                uint16_t x;
+                memcpy(&x, p, 2);
+                x = rts_bswap16(x);
+                memcpy(p, &x, 2);
+            }
+            break;
+        case 4:
+            for (size_t k = 0; k < run->count; k++, p += 4) {
+                uint32_t x;
+                memcpy(&x, p, 4);
+                x = rts_bswap32(x);
+                memcpy(p, &x, 4);
+            }
+            break;
+        case 8:
+            for (size_t k = 0; k < run->count; k++, p += 8) {
+                uint64_t x;
+                memcpy(&x, p, 8);
+                x = rts_bswap64(x);
+                memcpy(p, &x, 8);
+            }
+            break;
+    }
+}
+
+void rts_swap(const RtsSwap *swap, void *dst, const void *src, size_t count) {
+    unsigned char *out = dst;
+    const unsigned char *in = src;
+    RTS_STATS_ADD(RTS_STAT_SWAP_BYTES, count * swap->stride);
+    RTS_PROBE2(swap, src, count);
+#ifdef RTS_SWAP_SSSE3
+    if (swap->masks != NULL) {
+        size_t done = rts_swap_vector(swap, out, in, count);
+        out += done * swap->stride;
+        in += done * swap->stride;
+        count -= done;
+    }
+#endif
+    for (size_t i = 0; i < count; i++, out += swap->stride, in += swap->stride) {
+        if (out != in) {
+            memcpy(out, in, swap->stride);
+        }
+        for (size_t r = 0; r < swap->num_runs; r++) {
+            rts_swap_run(&swap->runs[r], out);
+        }
+    }
+}
+
+typedef struct _RtsSwapChunks {
+    const RtsSwap *swap;
+    const unsigned char *src;
+} RtsSwapChunks;
+
+static void rts_swap_chunk(void *arg, void *records, size_t first, size_t count) {
+    RtsSwapChunks *chunks = arg;
+    rts_swap(chunks->swap, records, chunks->src + first * chunks->swap->stride, count);
+}
+
+void rts_swap_parallel(const RtsSwap *swap, void *dst, const void *src, size_t count,
+                       const RtsExecutor *executor) {
+    RtsSwapChunks chunks = {swap, src};
+    rts_parallel_chunks(executor, swap->stride, dst, count, 1, rts_swap_chunk, &chunks);
+}
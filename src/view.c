@@ -0,0 +1,125 @@
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <rts/rts.h>
+
+#include "internal.h"
+
+static bool rts_view_type_ok(const RtsType *type) {
+    size_t alignment = type->alignment;
+    if (type->size == 0 || alignment == 0 || rts_type_is_variable(type)) {
+        return false;
+    }
+    if ((alignment & (alignment - 1)) != 0 || type->size % alignment != 0) {
+        return false;
+    }
+    // Mappings are page aligned so every record is aligned as long as
+    // the type does not ask for more than a page.
+    long page_size = sysconf(_SC_PAGESIZE);
+    return page_size <= 0 || alignment <= (size_t) page_size;
+}
+
+static void rts_view_advise(void *base, size_t length, int flags) {
+    if (flags & RTS_VIEW_FLAG_SEQUENTIAL) {
+        madvise(base, length, MADV_SEQUENTIAL);
+    } else if (flags & RTS_VIEW_FLAG_RANDOM) {
+        madvise(base, length, MADV_RANDOM);
+    }
+#ifdef MADV_HUGEPAGE
+    if (flags & RTS_VIEW_FLAG_HUGE_PAGES) {
+        // Only a hint, the kernel may not support huge pages for this file
+        madvise(base, length, MADV_HUGEPAGE);
+    }
+#endif
+}
+
+RtsStatus rts_view_open(RtsView *view, const RtsType *type, const char *path, int flags) {
+    if (view == NULL || type == NULL || path == NULL) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+    view->type = type;
+    view->base = NULL;
+    view->length = 0;
+    view->count = 0;
+    if (!rts_view_type_ok(type)) {
+        return RTS_STATUS_BAD_TYPEDEF;
+    }
+
+    bool writable = (flags & RTS_VIEW_FLAG_WRITABLE) != 0;
+    int fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        return RTS_STATUS_IO_ERROR;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return RTS_STATUS_IO_ERROR;
+    }
+    if (st.st_size < 0 || (uintmax_t) st.st_size > SIZE_MAX) {
+        close(fd);
+        return RTS_STATUS_BAD_SIZE;
+    }
+    size_t length = (size_t) st.st_size;
+    if (length % type->size != 0) {
+        close(fd);
+        return RTS_STATUS_BAD_SIZE;
+    }
+    if (length == 0) { // Nothing to map
+        close(fd);
+        return RTS_STATUS_OK;
+    }
+
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *base = mmap(NULL, length, prot, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file
+    if (base == MAP_FAILED) {
+        return RTS_STATUS_IO_ERROR;
+    }
+    rts_view_advise(base, length, flags);
+
+    view->base = base;
+    view->length = length;
+    view->count = length / type->size;
+    RTS_STATS_ADD(RTS_STAT_VIEW_BYTES, length);
+    return RTS_STATUS_OK;
+}
+
+void rts_view_close(RtsView *view) {
+    if (view == NULL) {
+        return;
+    }
+    if (view->base != NULL) {
+        munmap(view->base, view->length);
+    }
+    view->base = NULL;
+    view->length = 0;
+    view->count = 0;
+}
+
+void *rts_view_at(const RtsView *view, size_t index) {
+    if (view == NULL || index >= view->count) {
+        return NULL;
+    }
+    return (unsigned char *) view->base + index * view->type->size;
+}
+
+void rts_view_iter_init(RtsViewIter *iter, const RtsView *view) {
+    iter->view = view;
+    iter->index = 0;
+}
+
+void *rts_view_iter_next(RtsViewIter *iter) {
+    void *record = rts_view_at(iter->view, iter->index);
+    if (record != NULL) {
+        iter->index++;
+    }
+    return record;
+}
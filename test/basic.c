@@ -28,4 +28,25 @@ CL_SPEC(basic) {
     cl_assert(offsets[2] == offsetof(struct s, x));
 }
 
-CL_BUNDLE(basic);
\ No newline at end of file
+// Unions are as large as their largest member
+CL_SPEC(basic_union) {
+
+    union u {
+        char c;
+        double d;
+        int x;
+    };
+
+    RtsType *elements[] = {&RTS_TYPE_CHAR, &RTS_TYPE_DOUBLE, &RTS_TYPE_SINT, NULL};
+    RtsType test_type;
+    test_type.tag = RTS_TYPE_TAG_UNION;
+    test_type.elements = elements;
+    test_type.offsets = NULL;
+
+    cl_assert(rts_type_init(&test_type) == RTS_STATUS_OK);
+
+    cl_assert(test_type.size == sizeof(union u));
+    cl_assert(test_type.alignment == offsetof(struct { char c; union u x; }, x));
+}
+
+CL_BUNDLE(basic, basic_union);
\ No newline at end of file
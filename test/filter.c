@@ -0,0 +1,249 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chlorine.h>
+#include <rts/rts.h>
+
+#define NUM_RECS 200
+
+struct rec {
+    int32_t a;
+    uint8_t b;
+    double c;
+    int16_t d;
+};
+
+static RtsType *rec_elements[] = {&RTS_TYPE_SINT32, &RTS_TYPE_UINT8, &RTS_TYPE_DOUBLE, &RTS_TYPE_SINT16, NULL};
+static size_t rec_offsets[4];
+
+static void rec_type_init(RtsType *type) {
+    type->tag = RTS_TYPE_TAG_STRUCT;
+    type->elements = rec_elements;
+    type->offsets = rec_offsets;
+    cl_assert(rts_type_init(type) == RTS_STATUS_OK);
+}
+
+static void recs_init(struct rec *recs) {
+    memset(recs, 0, NUM_RECS * sizeof(*recs));
+    for (int i = 0; i < NUM_RECS; i++) {
+        recs[i].a = i - 100;
+        recs[i].b = (uint8_t) (i % 7);
+        recs[i].c = i * 0.25;
+        recs[i].d = (int16_t) (i % 3);
+    }
+}
+
+static bool bitmap_get(const uint64_t *bitmap, size_t i) {
+    return (bitmap[i / 64] >> (i % 64)) & 1;
+}
+
+static bool compare(RtsFilterOp op, double v, double c) {
+    switch (op) {
+        case RTS_FILTER_OP_EQ: return v == c;
+        case RTS_FILTER_OP_NE: return v != c;
+        case RTS_FILTER_OP_LT: return v < c;
+        case RTS_FILTER_OP_LE: return v <= c;
+        case RTS_FILTER_OP_GT: return v > c;
+        default: return v >= c;
+    }
+}
+
+static void filter_run(const RtsType *type, const RtsFilterExpr *expr, const void *records, uint64_t *bitmap) {
+    RtsFilter filter;
+    cl_assert(rts_filter_compile(&filter, type, expr) == RTS_STATUS_OK);
+    rts_filter_bitmap(&filter, records, NUM_RECS, bitmap);
+    rts_filter_free(&filter);
+}
+
+// A single compare matches the same records as the equivalent C expression
+CL_SPEC(filter_compare) {
+
+    RtsType rec_type;
+    rec_type_init(&rec_type);
+    struct rec recs[NUM_RECS];
+    recs_init(recs);
+
+    RtsFilterExpr lt = {RTS_FILTER_OP_LT, 0, {.s = -50}, NULL, NULL};
+    RtsFilter filter;
+    cl_assert(rts_filter_compile(&filter, &rec_type, &lt) == RTS_STATUS_OK);
+
+    uint64_t bitmap[(NUM_RECS + 63) / 64];
+    rts_filter_bitmap(&filter, recs, NUM_RECS, bitmap);
+    for (size_t i = 0; i < NUM_RECS; i++) {
+        cl_assert(bitmap_get(bitmap, i) == (recs[i].a < -50));
+    }
+    cl_assert((bitmap[3] >> (NUM_RECS % 64)) == 0);
+
+    size_t indices[NUM_RECS];
+    cl_assert(rts_filter_indices(&filter, recs, NUM_RECS, indices) == 50);
+    cl_assert(indices[0] == 0 && indices[49] == 49);
+    rts_filter_free(&filter);
+
+    // Constants outside of the field range are compared exactly
+    RtsFilterExpr big = {RTS_FILTER_OP_LT, 1, {.u = 300}, NULL, NULL};
+    cl_assert(rts_filter_compile(&filter, &rec_type, &big) == RTS_STATUS_OK);
+    cl_assert(rts_filter_indices(&filter, recs, NUM_RECS, indices) == NUM_RECS);
+    rts_filter_free(&filter);
+
+    // Records that hold nothing but the field are compared in place
+    RtsType *elements[] = {&RTS_TYPE_UINT32, NULL};
+    size_t offsets[1];
+    RtsType val_type;
+    val_type.tag = RTS_TYPE_TAG_STRUCT;
+    val_type.elements = elements;
+    val_type.offsets = offsets;
+    cl_assert(rts_type_init(&val_type) == RTS_STATUS_OK);
+    uint32_t vals[NUM_RECS];
+    for (uint32_t i = 0; i < NUM_RECS; i++) {
+        vals[i] = i * 7;
+    }
+    RtsFilterExpr ge = {RTS_FILTER_OP_GE, 0, {.u = 700}, NULL, NULL};
+    cl_assert(rts_filter_compile(&filter, &val_type, &ge) == RTS_STATUS_OK);
+    cl_assert(rts_filter_indices(&filter, vals, NUM_RECS, indices) == NUM_RECS - 100);
+    cl_assert(indices[0] == 100);
+    rts_filter_free(&filter);
+}
+
+// AND/OR trees match the same records as the equivalent C expression
+CL_SPEC(filter_tree) {
+
+    RtsType rec_type;
+    rec_type_init(&rec_type);
+    struct rec recs[NUM_RECS];
+    recs_init(recs);
+
+    // (b == 3 OR c >= 40.5) AND (d != 0 OR a > 90)
+    RtsFilterExpr b_eq = {RTS_FILTER_OP_EQ, 1, {.u = 3}, NULL, NULL};
+    RtsFilterExpr c_ge = {RTS_FILTER_OP_GE, 2, {.f = 40.5}, NULL, NULL};
+    RtsFilterExpr d_ne = {RTS_FILTER_OP_NE, 3, {.s = 0}, NULL, NULL};
+    RtsFilterExpr a_gt = {RTS_FILTER_OP_GT, 0, {.s = 90}, NULL, NULL};
+    RtsFilterExpr lhs = {RTS_FILTER_OP_OR, 0, {0}, &b_eq, &c_ge};
+    RtsFilterExpr rhs = {RTS_FILTER_OP_OR, 0, {0}, &d_ne, &a_gt};
+    RtsFilterExpr expr = {RTS_FILTER_OP_AND, 0, {0}, &lhs, &rhs};
+
+    RtsFilter filter;
+    cl_assert(rts_filter_compile(&filter, &rec_type, &expr) == RTS_STATUS_OK);
+
+    uint64_t bitmap[(NUM_RECS + 63) / 64];
+    rts_filter_bitmap(&filter, recs, NUM_RECS, bitmap);
+    size_t expected = 0;
+    for (size_t i = 0; i < NUM_RECS; i++) {
+        bool match = (recs[i].b == 3 || recs[i].c >= 40.5) && (recs[i].d != 0 || recs[i].a > 90);
+        cl_assert(bitmap_get(bitmap, i) == match);
+        expected += match;
+    }
+
+    size_t indices[NUM_RECS];
+    cl_assert(rts_filter_indices(&filter, recs, NUM_RECS, indices) == expected);
+    rts_filter_free(&filter);
+}
+
+// Constants are narrowed to the field type without changing any result
+CL_SPEC(filter_narrow) {
+
+    struct num {
+        float f;
+        uint16_t u;
+        int8_t s;
+    };
+
+    RtsType *elements[] = {&RTS_TYPE_FLOAT, &RTS_TYPE_UINT16, &RTS_TYPE_SINT8, NULL};
+    size_t offsets[3];
+    RtsType num_type;
+    num_type.tag = RTS_TYPE_TAG_STRUCT;
+    num_type.elements = elements;
+    num_type.offsets = offsets;
+    cl_assert(rts_type_init(&num_type) == RTS_STATUS_OK);
+
+    struct num nums[NUM_RECS];
+    for (int i = 0; i < NUM_RECS; i++) {
+        nums[i].f = (float) (i - 100) * 0.1f;
+        nums[i].u = (uint16_t) (i * 331);
+        nums[i].s = (int8_t) (i - 100);
+    }
+    nums[0].f = INFINITY;
+    nums[1].f = -INFINITY;
+    nums[2].f = NAN;
+
+    double floats[] = {0.1, -2.5, 0.0, 1e300, -1e300, INFINITY, NAN};
+    uint64_t uints[] = {0, 331, 65535, 65536, UINT64_MAX};
+    int64_t sints[] = {-129, -128, 0, 127, 128, INT64_MIN};
+    uint64_t bitmap[(NUM_RECS + 63) / 64];
+    for (RtsFilterOp op = RTS_FILTER_OP_EQ; op <= RTS_FILTER_OP_GE; op++) {
+        for (size_t k = 0; k < sizeof(floats) / sizeof(floats[0]); k++) {
+            RtsFilterExpr expr = {op, 0, {.f = floats[k]}, NULL, NULL};
+            filter_run(&num_type, &expr, nums, bitmap);
+            for (size_t i = 0; i < NUM_RECS; i++) {
+                cl_assert(bitmap_get(bitmap, i) == compare(op, nums[i].f, floats[k]));
+            }
+        }
+        for (size_t k = 0; k < sizeof(uints) / sizeof(uints[0]); k++) {
+            RtsFilterExpr expr = {op, 1, {.u = uints[k]}, NULL, NULL};
+            filter_run(&num_type, &expr, nums, bitmap);
+            for (size_t i = 0; i < NUM_RECS; i++) {
+                cl_assert(bitmap_get(bitmap, i) == compare(op, nums[i].u, (double) uints[k]));
+            }
+        }
+        for (size_t k = 0; k < sizeof(sints) / sizeof(sints[0]); k++) {
+            RtsFilterExpr expr = {op, 2, {.s = sints[k]}, NULL, NULL};
+            filter_run(&num_type, &expr, nums, bitmap);
+            for (size_t i = 0; i < NUM_RECS; i++) {
+                cl_assert(bitmap_get(bitmap, i) == compare(op, nums[i].s, (double) sints[k]));
+            }
+        }
+    }
+}
+
+// Chains nested to the right need no more stack than chains nested to the left
+CL_SPEC(filter_nested) {
+
+    RtsType rec_type;
+    rec_type_init(&rec_type);
+    struct rec recs[NUM_RECS];
+    recs_init(recs);
+
+    RtsFilterExpr nes[20], eqs[20];
+    RtsFilterExpr ands[19], ors[19], mixed[19];
+    for (int k = 0; k < 20; k++) {
+        nes[k] = (RtsFilterExpr) {RTS_FILTER_OP_NE, 0, {.s = k * 5 - 100}, NULL, NULL};
+        eqs[k] = (RtsFilterExpr) {RTS_FILTER_OP_EQ, 0, {.s = k * 5 - 100}, NULL, NULL};
+    }
+    for (int k = 18; k >= 0; k--) {
+        ands[k] = (RtsFilterExpr) {RTS_FILTER_OP_AND, 0, {0}, &nes[k], k == 18 ? &nes[19] : &ands[k + 1]};
+        ors[k] = (RtsFilterExpr) {RTS_FILTER_OP_OR, 0, {0}, &eqs[k], k == 18 ? &eqs[19] : &ors[k + 1]};
+        mixed[k] = (RtsFilterExpr) {k % 2 ? RTS_FILTER_OP_OR : RTS_FILTER_OP_AND, 0, {0},
+                                    &eqs[k], k == 18 ? &eqs[19] : &mixed[k + 1]};
+    }
+
+    uint64_t and_bitmap[(NUM_RECS + 63) / 64];
+    uint64_t or_bitmap[(NUM_RECS + 63) / 64];
+    filter_run(&rec_type, &ands[0], recs, and_bitmap);
+    filter_run(&rec_type, &ors[0], recs, or_bitmap);
+    for (size_t i = 0; i < NUM_RECS; i++) {
+        bool listed = recs[i].a >= -100 && recs[i].a < 0 && recs[i].a % 5 == 0;
+        cl_assert(bitmap_get(and_bitmap, i) == !listed);
+        cl_assert(bitmap_get(or_bitmap, i) == listed);
+    }
+
+    // Alternating operators still take a slot per level
+    RtsFilter filter;
+    cl_assert(rts_filter_compile(&filter, &rec_type, &mixed[0]) == RTS_STATUS_BAD_EXPRESSION);
+}
+
+// Malformed expressions are rejected at compile time
+CL_SPEC(filter_bad_expression) {
+
+    RtsType rec_type;
+    rec_type_init(&rec_type);
+
+    RtsFilter filter;
+    RtsFilterExpr bad_field = {RTS_FILTER_OP_EQ, 4, {0}, NULL, NULL};
+    cl_assert(rts_filter_compile(&filter, &rec_type, &bad_field) == RTS_STATUS_BAD_EXPRESSION);
+    RtsFilterExpr leaf = {RTS_FILTER_OP_EQ, 0, {0}, NULL, NULL};
+    RtsFilterExpr missing = {RTS_FILTER_OP_AND, 0, {0}, &leaf, NULL};
+    cl_assert(rts_filter_compile(&filter, &rec_type, &missing) == RTS_STATUS_BAD_EXPRESSION);
+    cl_assert(rts_filter_compile(&filter, &RTS_TYPE_SINT32, &bad_field) == RTS_STATUS_BAD_TYPEDEF);
+}
+
+CL_BUNDLE(filter_compare, filter_tree, filter_narrow, filter_nested, filter_bad_expression);
@@ -0,0 +1,145 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chlorine.h>
+#include <rts/rts.h>
+
+// Padding holes match the ones the compiler inserts
+CL_SPEC(layout_holes) {
+
+    struct s {
+        char c;
+        double d;
+        char e;
+        int32_t f;
+    };
+
+    RtsType *elements[] = {&RTS_TYPE_CHAR, &RTS_TYPE_DOUBLE, &RTS_TYPE_CHAR, &RTS_TYPE_SINT32, NULL};
+    size_t offsets[4];
+    RtsType s_type;
+    s_type.tag = RTS_TYPE_TAG_STRUCT;
+    s_type.elements = elements;
+    s_type.offsets = offsets;
+    cl_assert(rts_type_init(&s_type) == RTS_STATUS_OK);
+
+    RtsLayout layout;
+    cl_assert(rts_layout_inspect(&layout, &s_type, NULL) == RTS_STATUS_OK);
+    cl_assert(layout.size == sizeof(struct s));
+    cl_assert(layout.num_fields == 4);
+    cl_assert(layout.fields[2].offset == offsetof(struct s, e));
+
+    cl_assert(layout.num_holes == 2);
+    cl_assert(layout.holes[0].offset == 1 && layout.holes[0].size == 7);
+    cl_assert(layout.holes[1].offset == 17 && layout.holes[1].size == 3);
+    cl_assert(layout.padding == 10);
+    cl_assert(layout.padding_ratio == 10.0 / sizeof(struct s));
+    cl_assert(layout.num_straddling == 0);
+    rts_layout_free(&layout);
+}
+
+// Nested members are listed after their parent and can straddle cache lines
+CL_SPEC(layout_nested) {
+
+    struct inner {
+        uint64_t x;
+        uint64_t y;
+    };
+    struct outer {
+        uint32_t a;
+        struct inner in;
+    };
+
+    RtsType *inner_elements[] = {&RTS_TYPE_UINT64, &RTS_TYPE_UINT64, NULL};
+    size_t inner_offsets[2];
+    RtsType inner_type;
+    inner_type.tag = RTS_TYPE_TAG_STRUCT;
+    inner_type.elements = inner_elements;
+    inner_type.offsets = inner_offsets;
+
+    RtsType *outer_elements[] = {&RTS_TYPE_UINT32, &inner_type, NULL};
+    size_t outer_offsets[2];
+    RtsType outer_type;
+    outer_type.tag = RTS_TYPE_TAG_STRUCT;
+    outer_type.elements = outer_elements;
+    outer_type.offsets = outer_offsets;
+    cl_assert(rts_type_init(&outer_type) == RTS_STATUS_OK);
+
+    RtsLayout layout;
+    cl_assert(rts_layout_inspect(&layout, &outer_type, NULL) == RTS_STATUS_OK);
+    cl_assert(layout.num_fields == 4);
+    cl_assert(layout.fields[1].type == &inner_type && layout.fields[1].depth == 0);
+    cl_assert(layout.fields[3].parent == &inner_type && layout.fields[3].depth == 1);
+    cl_assert(layout.fields[3].offset == offsetof(struct outer, in) + offsetof(struct inner, y));
+
+    // Packed in an array, every third record places `in` across a line
+    cl_assert(layout.fields[1].straddles);
+    cl_assert(!layout.fields[2].straddles && !layout.fields[3].straddles);
+    cl_assert(layout.num_straddling == 1);
+
+    cl_assert(layout.num_holes == 1);
+    cl_assert(layout.holes[0].offset == 4 && layout.holes[0].size == 4);
+    rts_layout_free(&layout);
+}
+
+// Access frequencies split fields into hot and cold sets
+CL_SPEC(layout_hot_cold) {
+
+    RtsType *elements[] = {&RTS_TYPE_UINT64, &RTS_TYPE_UINT64, &RTS_TYPE_UINT64, &RTS_TYPE_UINT64,
+                           &RTS_TYPE_UINT64, &RTS_TYPE_UINT64, &RTS_TYPE_UINT64, &RTS_TYPE_UINT64,
+                           &RTS_TYPE_UINT64, NULL};
+    size_t offsets[9];
+    RtsType s_type;
+    s_type.tag = RTS_TYPE_TAG_STRUCT;
+    s_type.elements = elements;
+    s_type.offsets = offsets;
+    cl_assert(rts_type_init(&s_type) == RTS_STATUS_OK);
+
+    double frequencies[] = {100, 0, 0, 0, 0, 0, 0, 0, 90};
+    RtsLayout layout;
+    cl_assert(rts_layout_inspect(&layout, &s_type, frequencies) == RTS_STATUS_OK);
+    cl_assert(layout.lines == 2);
+    cl_assert(layout.fields[0].hot && layout.fields[8].hot && !layout.fields[1].hot);
+    cl_assert(layout.hot_size == 16);
+    cl_assert(layout.hot_lines == 2);
+    cl_assert(layout.hot_lines_packed == 1);
+    rts_layout_free(&layout);
+}
+
+// Overlapping union members only count their shared bytes once
+CL_SPEC(layout_hot_union) {
+
+    struct s {
+        uint16_t a;
+        union {
+            uint8_t b;
+            uint64_t c;
+        } u;
+    };
+
+    RtsType *u_elements[] = {&RTS_TYPE_UINT8, &RTS_TYPE_UINT64, NULL};
+    size_t u_offsets[2];
+    RtsType u_type;
+    u_type.tag = RTS_TYPE_TAG_UNION;
+    u_type.elements = u_elements;
+    u_type.offsets = u_offsets;
+
+    RtsType *elements[] = {&RTS_TYPE_UINT16, &u_type, NULL};
+    size_t offsets[2];
+    RtsType s_type;
+    s_type.tag = RTS_TYPE_TAG_STRUCT;
+    s_type.elements = elements;
+    s_type.offsets = offsets;
+    cl_assert(rts_type_init(&s_type) == RTS_STATUS_OK);
+    cl_assert(s_type.size == sizeof(struct s));
+
+    double frequencies[] = {1, 1, 1, 1};
+    RtsLayout layout;
+    cl_assert(rts_layout_inspect(&layout, &s_type, frequencies) == RTS_STATUS_OK);
+    cl_assert(layout.fields[0].hot && layout.fields[2].hot && layout.fields[3].hot);
+    cl_assert(layout.hot_size == 10);
+    cl_assert(layout.hot_lines == 1);
+    cl_assert(layout.hot_lines_packed == 1);
+    rts_layout_free(&layout);
+}
+
+CL_BUNDLE(layout_holes, layout_nested, layout_hot_cold, layout_hot_union);
@@ -0,0 +1,122 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chlorine.h>
+#include <rts/rts.h>
+
+#define NUM_RECS 100000
+
+struct rec {
+    uint32_t key;
+    uint32_t visits;
+    double value;
+};
+
+static struct rec *recs_new(void) {
+    struct rec *recs = calloc(NUM_RECS, sizeof(struct rec));
+    for (size_t i = 0; i < NUM_RECS; i++) {
+        recs[i].key = (uint32_t) (i * 2654435761u);
+    }
+    return recs;
+}
+
+static void visit_chunk(void *arg, void *records, size_t first, size_t count) {
+    struct rec *recs = records;
+    for (size_t i = 0; i < count; i++) {
+        recs[i].visits++;
+    }
+}
+
+typedef struct order {
+    size_t next;
+    bool in_order;
+} order;
+
+static void order_chunk(void *arg, void *records, size_t first, size_t count) {
+    order *o = arg;
+    o->in_order = o->in_order && first == o->next;
+    o->next = first + count;
+}
+
+// Every record is handed to exactly one chunk, whatever the pool size
+CL_SPEC(pool_parallel_for) {
+
+    RtsType *elements[] = {&RTS_TYPE_UINT32, &RTS_TYPE_UINT32, &RTS_TYPE_DOUBLE, NULL};
+    size_t offsets[3];
+    RtsType rec_type;
+    rec_type.tag = RTS_TYPE_TAG_STRUCT;
+    rec_type.elements = elements;
+    rec_type.offsets = offsets;
+    cl_assert(rts_type_init(&rec_type) == RTS_STATUS_OK);
+    struct rec *recs = recs_new();
+
+    size_t sizes[] = {0, 1, 4};
+    for (size_t s = 0; s < 3; s++) {
+        RtsPool *pool;
+        RtsStatus status = rts_pool_create(&pool, sizes[s]);
+        if (status == RTS_STATUS_UNSUPPORTED) { // Built without threads
+            cl_assert(sizes[s] > 0);
+            cl_assert(rts_parallel_for(NULL, &rec_type, recs, NUM_RECS, visit_chunk, NULL) == RTS_STATUS_OK);
+            continue;
+        }
+        cl_assert(status == RTS_STATUS_OK);
+        RtsExecutor executor = rts_pool_executor(pool);
+        cl_assert(rts_parallel_for(&executor, &rec_type, recs, NUM_RECS, visit_chunk, NULL) == RTS_STATUS_OK);
+        rts_pool_destroy(pool);
+    }
+    for (size_t i = 0; i < NUM_RECS; i++) {
+        cl_assert(recs[i].visits == 3);
+    }
+
+    // Without an executor chunks run in order on the calling thread
+    order o = {0, true};
+    cl_assert(rts_parallel_for(NULL, &rec_type, recs, NUM_RECS, order_chunk, &o) == RTS_STATUS_OK);
+    cl_assert(o.in_order && o.next == NUM_RECS);
+    free(recs);
+}
+
+// Filtering in parallel produces the same bitmap as filtering serially
+CL_SPEC(pool_filter) {
+
+    RtsType *elements[] = {&RTS_TYPE_UINT32, &RTS_TYPE_UINT32, &RTS_TYPE_DOUBLE, NULL};
+    size_t offsets[3];
+    RtsType rec_type;
+    rec_type.tag = RTS_TYPE_TAG_STRUCT;
+    rec_type.elements = elements;
+    rec_type.offsets = offsets;
+    cl_assert(rts_type_init(&rec_type) == RTS_STATUS_OK);
+    struct rec *recs = recs_new();
+
+    RtsFilterExpr expr = {RTS_FILTER_OP_LT, 0, {.u = 1u << 30}, NULL, NULL};
+    RtsFilter filter;
+    cl_assert(rts_filter_compile(&filter, &rec_type, &expr) == RTS_STATUS_OK);
+
+    size_t words = (NUM_RECS + 63) / 64;
+    uint64_t *serial = calloc(words, sizeof(uint64_t));
+    uint64_t *parallel = calloc(words, sizeof(uint64_t));
+    rts_filter_bitmap(&filter, recs, NUM_RECS, serial);
+
+    RtsPool *pool = NULL;
+    RtsStatus status = rts_pool_create(&pool, 4);
+    cl_assert(status == RTS_STATUS_OK || status == RTS_STATUS_UNSUPPORTED);
+    RtsExecutor executor;
+    if (status == RTS_STATUS_OK) {
+        executor = rts_pool_executor(pool);
+    }
+    for (int run = 0; run < 8; run++) {
+        memset(parallel, 0, words * sizeof(uint64_t));
+        rts_filter_bitmap_parallel(&filter, recs, NUM_RECS, parallel,
+                                   status == RTS_STATUS_OK ? &executor : NULL);
+        cl_assert(memcmp(serial, parallel, words * sizeof(uint64_t)) == 0);
+    }
+    if (status == RTS_STATUS_OK) {
+        rts_pool_destroy(pool);
+    }
+
+    rts_filter_free(&filter);
+    free(parallel);
+    free(serial);
+    free(recs);
+}
+
+CL_BUNDLE(pool_parallel_for, pool_filter);
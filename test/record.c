@@ -0,0 +1,149 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chlorine.h>
+#include <rts/rts.h>
+
+struct msg {
+    uint64_t id;
+    uint16_t n;
+    uint32_t vals[];
+};
+
+static RtsType *vals_elements[] = {&RTS_TYPE_UINT32, NULL};
+static RtsType *msg_elements[4];
+static size_t msg_offsets[3];
+
+static void msg_type_init(RtsType *vals_type, RtsType *msg_type) {
+    vals_type->tag = RTS_TYPE_TAG_FLEXIBLE;
+    vals_type->elements = vals_elements;
+    vals_type->offsets = NULL;
+    vals_type->count_field = 1;
+
+    msg_elements[0] = &RTS_TYPE_UINT64;
+    msg_elements[1] = &RTS_TYPE_UINT16;
+    msg_elements[2] = vals_type;
+    msg_elements[3] = NULL;
+    msg_type->tag = RTS_TYPE_TAG_STRUCT;
+    msg_type->elements = msg_elements;
+    msg_type->offsets = msg_offsets;
+    cl_assert(rts_type_init(msg_type) == RTS_STATUS_OK);
+}
+
+static void count_chunk(void *arg, void *records, size_t first, size_t count) {
+    (*(size_t *) arg)++;
+}
+
+// A trailing flexible array member is laid out the way the compiler does it
+CL_SPEC(record_flexible_layout) {
+
+    RtsType vals_type, msg_type;
+    msg_type_init(&vals_type, &msg_type);
+
+    cl_assert(rts_type_is_variable(&msg_type));
+    cl_assert(msg_type.size == sizeof(struct msg));
+    cl_assert(msg_offsets[1] == offsetof(struct msg, n));
+    cl_assert(msg_offsets[2] == offsetof(struct msg, vals));
+
+    union {
+        struct msg m;
+        unsigned char bytes[64];
+    } buffer;
+    buffer.m.id = 1;
+    buffer.m.n = 5;
+    size_t size;
+    cl_assert(rts_record_size(&msg_type, &buffer, &size) == RTS_STATUS_OK);
+    cl_assert(size == offsetof(struct msg, vals) + 5 * sizeof(uint32_t));
+
+    // Fixed-stride operations refuse variable-length records
+    RtsSwap swap;
+    cl_assert(rts_swap_compile(&swap, &msg_type) == RTS_STATUS_BAD_TYPEDEF);
+    RtsFilter filter;
+    RtsFilterExpr expr = {RTS_FILTER_OP_EQ, 0, {0}, NULL, NULL};
+    cl_assert(rts_filter_compile(&filter, &msg_type, &expr) == RTS_STATUS_BAD_TYPEDEF);
+    RtsLayout layout;
+    cl_assert(rts_layout_inspect(&layout, &msg_type, NULL) == RTS_STATUS_BAD_TYPEDEF);
+    size_t chunks = 0;
+    cl_assert(rts_parallel_for(NULL, &msg_type, &buffer, 2, count_chunk, &chunks) == RTS_STATUS_BAD_TYPEDEF);
+    cl_assert(chunks == 0);
+}
+
+// Flexible members must come last and be counted by an earlier integer field
+CL_SPEC(record_bad_typedef) {
+
+    RtsType vals_type;
+    vals_type.tag = RTS_TYPE_TAG_FLEXIBLE;
+    vals_type.elements = vals_elements;
+    vals_type.offsets = NULL;
+    vals_type.count_field = 0;
+
+    RtsType *not_last[] = {&RTS_TYPE_UINT32, &vals_type, &RTS_TYPE_UINT32, NULL};
+    RtsType *float_count[] = {&RTS_TYPE_FLOAT, &vals_type, NULL};
+    RtsType *only[] = {&vals_type, NULL};
+    size_t offsets[3];
+    RtsType bad_type;
+    bad_type.tag = RTS_TYPE_TAG_STRUCT;
+    bad_type.offsets = offsets;
+
+    bad_type.elements = not_last;
+    cl_assert(rts_type_init(&bad_type) == RTS_STATUS_BAD_TYPEDEF);
+    bad_type.elements = float_count;
+    cl_assert(rts_type_init(&bad_type) == RTS_STATUS_BAD_TYPEDEF);
+    bad_type.elements = only;
+    cl_assert(rts_type_init(&bad_type) == RTS_STATUS_BAD_TYPEDEF);
+
+    RtsType vals_type2, msg_type;
+    msg_type_init(&vals_type2, &msg_type);
+    RtsType *nested[] = {&RTS_TYPE_UINT32, &msg_type, NULL};
+    bad_type.elements = nested;
+    cl_assert(rts_type_init(&bad_type) == RTS_STATUS_BAD_TYPEDEF);
+}
+
+// The iterator walks back to back records in place and stops on truncation
+CL_SPEC(record_iter) {
+
+    RtsType vals_type, msg_type;
+    msg_type_init(&vals_type, &msg_type);
+
+    uint64_t storage[32];
+    unsigned char *buffer = (unsigned char *) storage;
+    size_t length = 0;
+    uint16_t counts[] = {0, 3, 1, 4};
+    for (size_t i = 0; i < 4; i++) {
+        struct msg *m = (struct msg *) (buffer + length);
+        m->id = i;
+        m->n = counts[i];
+        for (uint16_t k = 0; k < counts[i]; k++) {
+            m->vals[k] = (uint32_t) (i * 10 + k);
+        }
+        size_t size = offsetof(struct msg, vals) + counts[i] * sizeof(uint32_t);
+        length += (size + 7) / 8 * 8;
+    }
+
+    RtsRecordIter iter;
+    rts_record_iter_init(&iter, &msg_type, buffer, length);
+    const struct msg *m;
+    size_t size;
+    size_t n = 0;
+    while ((m = rts_record_iter_next(&iter, &size)) != NULL) {
+        cl_assert(m->id == n && m->n == counts[n]);
+        cl_assert(size == offsetof(struct msg, vals) + counts[n] * sizeof(uint32_t));
+        if (m->n > 0) {
+            cl_assert(m->vals[m->n - 1] == n * 10 + m->n - 1);
+        }
+        n++;
+    }
+    cl_assert(n == 4);
+    cl_assert(iter.status == RTS_STATUS_OK);
+
+    // The last record is cut short, so only the first three come back
+    rts_record_iter_init(&iter, &msg_type, buffer, length - 12);
+    n = 0;
+    while (rts_record_iter_next(&iter, NULL) != NULL) {
+        n++;
+    }
+    cl_assert(n == 3);
+    cl_assert(iter.status == RTS_STATUS_BAD_SIZE);
+}
+
+CL_BUNDLE(record_flexible_layout, record_bad_typedef, record_iter);
@@ -0,0 +1,68 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chlorine.h>
+#include <rts/rts.h>
+
+// Layout calls are counted when the library is built with RTS_WITH_STATS
+CL_SPEC(stats_layout) {
+
+    RtsType *inner_elements[] = {&RTS_TYPE_UINT8, &RTS_TYPE_UINT32, NULL};
+    size_t inner_offsets[2];
+    RtsType inner_type;
+    inner_type.tag = RTS_TYPE_TAG_STRUCT;
+    inner_type.elements = inner_elements;
+    inner_type.offsets = inner_offsets;
+
+    RtsType *outer_elements[] = {&inner_type, &RTS_TYPE_DOUBLE, NULL};
+    size_t outer_offsets[2];
+    RtsType outer_type;
+    outer_type.tag = RTS_TYPE_TAG_STRUCT;
+    outer_type.elements = outer_elements;
+    outer_type.offsets = outer_offsets;
+
+    RtsStats before, after;
+    RtsStatus status = rts_stats_thread(&before);
+    cl_assert(rts_type_init(&outer_type) == RTS_STATUS_OK);
+    cl_assert(rts_stats_thread(&after) == status);
+
+    if (status == RTS_STATUS_UNSUPPORTED) {
+        for (size_t i = 0; i < RTS_STAT_COUNT; i++) {
+            cl_assert(after.counters[i] == 0);
+        }
+        return;
+    }
+    cl_assert(status == RTS_STATUS_OK);
+    // One call per type in the tree, outer, inner and three scalars
+    cl_assert(after.counters[RTS_STAT_LAYOUT_CALLS] - before.counters[RTS_STAT_LAYOUT_CALLS] == 5);
+    cl_assert(after.counters[RTS_STAT_LAYOUT_ELEMENTS] - before.counters[RTS_STAT_LAYOUT_ELEMENTS] == 4);
+
+    RtsStats global;
+    cl_assert(rts_stats_global(&global) == RTS_STATUS_OK);
+    cl_assert(global.counters[RTS_STAT_LAYOUT_CALLS] >= after.counters[RTS_STAT_LAYOUT_CALLS]);
+}
+
+static void *swap_thread(void *arg) {
+    uint32_t words[100] = {0};
+    RtsSwap swap;
+    rts_swap_compile(&swap, &RTS_TYPE_UINT32);
+    rts_swap(&swap, words, words, 100);
+    rts_swap_free(&swap);
+    return NULL;
+}
+
+// Counters of threads that have exited still show up in global snapshots
+CL_SPEC(stats_retired_threads) {
+
+    RtsStats before, after;
+    if (rts_stats_global(&before) != RTS_STATUS_OK) {
+        return;
+    }
+    pthread_t thread;
+    cl_assert(pthread_create(&thread, NULL, swap_thread, NULL) == 0);
+    pthread_join(thread, NULL);
+    cl_assert(rts_stats_global(&after) == RTS_STATUS_OK);
+    cl_assert(after.counters[RTS_STAT_SWAP_BYTES] - before.counters[RTS_STAT_SWAP_BYTES] == 400);
+}
+
+CL_BUNDLE(stats_layout, stats_retired_threads);
@@ -0,0 +1,135 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chlorine.h>
+#include <rts/rts.h>
+
+#define NUM_RECS 1001
+
+struct rec {
+    uint16_t a;
+    uint8_t b;
+    uint32_t c;
+    uint64_t d;
+    int16_t e;
+    int16_t f;
+};
+
+struct triple {
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+};
+
+static void fill(void *buffer, size_t length) {
+    unsigned char *p = buffer;
+    for (size_t i = 0; i < length; i++) {
+        p[i] = (unsigned char) (i * 31 + 7);
+    }
+}
+
+static uint16_t swap16(uint16_t x) {
+    return (uint16_t) ((x >> 8) | (x << 8));
+}
+
+static uint32_t swap32(uint32_t x) {
+    return ((uint32_t) swap16((uint16_t) x) << 16) | swap16((uint16_t) (x >> 16));
+}
+
+static uint64_t swap64(uint64_t x) {
+    return ((uint64_t) swap32((uint32_t) x) << 32) | swap32((uint32_t) (x >> 32));
+}
+
+// Every multi-byte field is swapped while single bytes and padding are kept
+CL_SPEC(swap_struct) {
+
+    RtsType *elements[] = {&RTS_TYPE_UINT16, &RTS_TYPE_UINT8, &RTS_TYPE_UINT32, &RTS_TYPE_UINT64,
+                           &RTS_TYPE_SINT16, &RTS_TYPE_SINT16, NULL};
+    size_t offsets[6];
+    RtsType rec_type;
+    rec_type.tag = RTS_TYPE_TAG_STRUCT;
+    rec_type.elements = elements;
+    rec_type.offsets = offsets;
+    cl_assert(rts_type_init(&rec_type) == RTS_STATUS_OK);
+
+    RtsSwap swap;
+    cl_assert(rts_swap_compile(&swap, &rec_type) == RTS_STATUS_OK);
+    cl_assert(swap.num_runs == 4); // e and f share a run, b is skipped
+
+    static struct rec src[NUM_RECS], dst[NUM_RECS];
+    fill(src, sizeof(src));
+    rts_swap(&swap, dst, src, NUM_RECS);
+    for (size_t i = 0; i < NUM_RECS; i++) {
+        cl_assert(dst[i].a == swap16(src[i].a));
+        cl_assert(dst[i].b == src[i].b);
+        cl_assert(dst[i].c == swap32(src[i].c));
+        cl_assert(dst[i].d == swap64(src[i].d));
+        cl_assert((uint16_t) dst[i].e == swap16((uint16_t) src[i].e));
+        cl_assert((uint16_t) dst[i].f == swap16((uint16_t) src[i].f));
+        cl_assert(((unsigned char *) &dst[i])[3] == ((unsigned char *) &src[i])[3]);
+    }
+
+    // Swapping in place twice restores the records
+    memcpy(dst, src, sizeof(src));
+    rts_swap(&swap, dst, dst, NUM_RECS);
+    rts_swap(&swap, dst, dst, NUM_RECS);
+    cl_assert(memcmp(dst, src, sizeof(src)) == 0);
+    rts_swap_free(&swap);
+}
+
+// Small records are swapped several at a time, with a scalar tail
+CL_SPEC(swap_small_records) {
+
+    RtsType *elements[] = {&RTS_TYPE_UINT16, &RTS_TYPE_UINT16, &RTS_TYPE_UINT16, NULL};
+    size_t offsets[3];
+    RtsType triple_type;
+    triple_type.tag = RTS_TYPE_TAG_STRUCT;
+    triple_type.elements = elements;
+    triple_type.offsets = offsets;
+    cl_assert(rts_type_init(&triple_type) == RTS_STATUS_OK);
+
+    RtsSwap swap;
+    cl_assert(rts_swap_compile(&swap, &triple_type) == RTS_STATUS_OK);
+    cl_assert(swap.num_runs == 1);
+
+    static struct triple src[NUM_RECS], dst[NUM_RECS], par[NUM_RECS];
+    fill(src, sizeof(src));
+    rts_swap(&swap, dst, src, NUM_RECS);
+    for (size_t i = 0; i < NUM_RECS; i++) {
+        cl_assert(dst[i].x == swap16(src[i].x));
+        cl_assert(dst[i].y == swap16(src[i].y));
+        cl_assert(dst[i].z == swap16(src[i].z));
+    }
+
+    rts_swap_parallel(&swap, par, src, NUM_RECS, NULL);
+    cl_assert(memcmp(dst, par, sizeof(dst)) == 0);
+    rts_swap_free(&swap);
+
+    // Plain arrays of scalars work too
+    uint32_t words[37], swapped[37];
+    fill(words, sizeof(words));
+    cl_assert(rts_swap_compile(&swap, &RTS_TYPE_UINT32) == RTS_STATUS_OK);
+    rts_swap(&swap, swapped, words, 37);
+    for (size_t i = 0; i < 37; i++) {
+        cl_assert(swapped[i] == swap32(words[i]));
+    }
+    rts_swap_free(&swap);
+}
+
+// Unions cannot be swapped without knowing their active member
+CL_SPEC(swap_union) {
+
+    RtsType *elements[] = {&RTS_TYPE_UINT32, &RTS_TYPE_FLOAT, NULL};
+    size_t offsets[2];
+    RtsType union_type;
+    union_type.tag = RTS_TYPE_TAG_UNION;
+    union_type.elements = elements;
+    union_type.offsets = offsets;
+    cl_assert(rts_type_init(&union_type) == RTS_STATUS_OK);
+
+    RtsSwap swap;
+    cl_assert(rts_swap_compile(&swap, &union_type) != RTS_STATUS_OK);
+    cl_assert(swap.runs == NULL);
+}
+
+CL_BUNDLE(swap_struct, swap_small_records, swap_union);
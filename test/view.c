@@ -0,0 +1,87 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <chlorine.h>
+#include <rts/rts.h>
+
+struct rec {
+    uint32_t id;
+    char c;
+    double value;
+};
+
+static void write_file(char *path, const void *data, size_t length) {
+    int fd = mkstemp(path);
+    cl_assert(fd >= 0);
+    cl_assert(write(fd, data, length) == (ssize_t) length);
+    close(fd);
+}
+
+// Map a file of records and read them back both randomly and sequentially
+CL_SPEC(view_records) {
+
+    RtsType *elements[] = {&RTS_TYPE_UINT32, &RTS_TYPE_CHAR, &RTS_TYPE_DOUBLE, NULL};
+    size_t offsets[3];
+    RtsType rec_type;
+    rec_type.tag = RTS_TYPE_TAG_STRUCT;
+    rec_type.elements = elements;
+    rec_type.offsets = offsets;
+    cl_assert(rts_type_init(&rec_type) == RTS_STATUS_OK);
+
+    struct rec recs[16];
+    memset(recs, 0, sizeof(recs));
+    for (size_t i = 0; i < 16; i++) {
+        recs[i].id = (uint32_t) i;
+        recs[i].c = (char) ('a' + i);
+        recs[i].value = i * 0.5;
+    }
+    char path[] = "/tmp/rts_view_XXXXXX";
+    write_file(path, recs, sizeof(recs));
+
+    RtsView view;
+    cl_assert(rts_view_open(&view, &rec_type, path, RTS_VIEW_FLAG_SEQUENTIAL) == RTS_STATUS_OK);
+    cl_assert(view.count == 16);
+
+    struct rec *r = rts_view_at(&view, 7);
+    cl_assert(r != NULL);
+    cl_assert(r->id == 7 && r->c == 'h' && r->value == 3.5);
+    cl_assert(rts_view_at(&view, 16) == NULL);
+
+    RtsViewIter iter;
+    rts_view_iter_init(&iter, &view);
+    size_t n = 0;
+    while ((r = rts_view_iter_next(&iter)) != NULL) {
+        cl_assert(r->id == n);
+        cl_assert(*(uint32_t *) ((char *) r + offsets[0]) == n);
+        n++;
+    }
+    cl_assert(n == 16);
+
+    rts_view_close(&view);
+    cl_assert(view.base == NULL && view.count == 0);
+    unlink(path);
+}
+
+// A file whose size is not a multiple of the record size is rejected
+CL_SPEC(view_bad_size) {
+
+    RtsType *elements[] = {&RTS_TYPE_UINT32, &RTS_TYPE_UINT32, NULL};
+    size_t offsets[2];
+    RtsType pair_type;
+    pair_type.tag = RTS_TYPE_TAG_STRUCT;
+    pair_type.elements = elements;
+    pair_type.offsets = offsets;
+    cl_assert(rts_type_init(&pair_type) == RTS_STATUS_OK);
+
+    char data[12] = {0};
+    char path[] = "/tmp/rts_view_XXXXXX";
+    write_file(path, data, sizeof(data));
+
+    RtsView view;
+    cl_assert(rts_view_open(&view, &pair_type, path, RTS_VIEW_FLAG_NONE) == RTS_STATUS_BAD_SIZE);
+    cl_assert(rts_view_open(&view, &pair_type, "/nonexistent/rts", RTS_VIEW_FLAG_NONE) == RTS_STATUS_IO_ERROR);
+    unlink(path);
+}
+
+CL_BUNDLE(view_records, view_bad_size);